@@ -8,6 +8,8 @@
 -# 矩形で指定できるEntityとアニメーションで指定できるEntity追加
 - 2018/12/20 tonarinohito
 -# TestArcheTypeをArcheTypeにリネーム
+- 2026/10/17 agent
+-# 大量に生成するためのPrefabを作る関数を追加
 */
 #pragma once
 #include "../GameController/GameController.h"
@@ -59,5 +61,30 @@ namespace ECS
 			entity->addGroup(group);
 			return entity;
 		}
+
+		/*!
+		@brief CreateEntity()と同じ構成のPrefabを作ります
+		@details EntityManager::instantiate()で生成し、座標は初期化関数でPosition2Dに設定してください
+		*/
+		static Prefab MakeEntityPrefab(const char* graphicName, const Group group)
+		{
+			Prefab prefab(group);
+			prefab.add<Transform2D>().add<Color>().add<AlphaBlend>().add<SpriteDraw>(graphicName);
+			return prefab;
+		}
+		//!CreateRectEntity()と同じ構成のPrefabを作ります
+		static Prefab MakeRectEntityPrefab(const char* graphicName, const Rectangle& rectangle, const Group group)
+		{
+			Prefab prefab(group);
+			prefab.add<Transform2D>().add<Color>().add<AlphaBlend>().add<Rectangle>(rectangle).add<SpriteRectDraw>(graphicName);
+			return prefab;
+		}
+		//!CreateMultiSpriteEntity()と同じ構成のPrefabを作ります
+		static Prefab MakeMultiSpriteEntityPrefab(const char* graphicName, const Group group)
+		{
+			Prefab prefab(group);
+			prefab.add<Transform2D>().add<Color>().add<AlphaBlend>().add<MultiSpriteDraw>(graphicName);
+			return prefab;
+		}
 	};
 }
\ No newline at end of file
@@ -29,6 +29,22 @@ namespace ECS
 			return entity;
 		}
 
+		//!CreateBox()と同じ構成のPrefabを作ります。座標はinstantiate()の初期化関数で設定してください
+		static Prefab MakeBoxPrefab(const Vec2& size)
+		{
+			Prefab prefab(ENTITY_GROUP::DEFAULT);
+			prefab.add<Transform2D>().add<BoxCollider>(size);
+			return prefab;
+		}
+
+		//!CreateCircle()と同じ構成のPrefabを作ります。座標はinstantiate()の初期化関数で設定してください
+		static Prefab MakeCirclePrefab(const float& radius)
+		{
+			Prefab prefab(ENTITY_GROUP::DEFAULT);
+			prefab.add<Transform2D>().add<CircleCollider>(radius);
+			return prefab;
+		}
+
 		static Entity* CreateLine(Entity* p1, Entity* p2,EntityManager& entityManager)
 		{
 			auto* entity = &entityManager.addEntity();
@@ -0,0 +1,223 @@
+﻿/**
+* @file AABB.hpp
+* @brief ブロードフェーズで使う軸に平行な矩形と、コライダーからの矩形の求め方をまとめたファイルです
+* @author agent
+* @date 2026/10/17
+*/
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "../ECS/ECS.hpp"
+#include "../Components/BasicComponents.hpp"
+#include "../Components/Collider.hpp"
+
+namespace ECS
+{
+	/**
+	* @brief 軸に平行な矩形です
+	* @details 判定は境界を含みます。ブロードフェーズでは候補を取りこぼさないことを優先するためです
+	*/
+	struct AABB final
+	{
+		//!左上の座標
+		Vec2 lower;
+		//!右下の座標
+		Vec2 upper;
+
+		AABB() = default;
+		AABB(const Vec2& setLower, const Vec2& setUpper) :
+			lower(setLower),
+			upper(setUpper)
+		{}
+		//!otherと重なっているか返します
+		[[nodiscard]] bool overlaps(const AABB& other) const noexcept
+		{
+			return lower.x <= other.upper.x && other.lower.x <= upper.x &&
+				lower.y <= other.upper.y && other.lower.y <= upper.y;
+		}
+		//!otherを完全に含んでいるか返します
+		[[nodiscard]] bool contains(const AABB& other) const noexcept
+		{
+			return lower.x <= other.lower.x && lower.y <= other.lower.y &&
+				other.upper.x <= upper.x && other.upper.y <= upper.y;
+		}
+		//!点を含んでいるか返します
+		[[nodiscard]] bool contains(const Vec2& point) const noexcept
+		{
+			return lower.x <= point.x && point.x <= upper.x &&
+				lower.y <= point.y && point.y <= upper.y;
+		}
+		//!周長を返します。木の構築でコストの目安に使います
+		[[nodiscard]] float perimeter() const noexcept
+		{
+			return 2.f * ((upper.x - lower.x) + (upper.y - lower.y));
+		}
+		//!四方にmarginだけ広げた矩形を返します
+		[[nodiscard]] AABB expanded(const float margin) const noexcept
+		{
+			return AABB(Vec2(lower.x - margin, lower.y - margin), Vec2(upper.x + margin, upper.y + margin));
+		}
+		//!2つの矩形を囲む矩形を返します
+		[[nodiscard]] static AABB Merge(const AABB& a, const AABB& b) noexcept
+		{
+			return AABB(
+				Vec2((std::min)(a.lower.x, b.lower.x), (std::min)(a.lower.y, b.lower.y)),
+				Vec2((std::max)(a.upper.x, b.upper.x), (std::max)(a.upper.y, b.upper.y)));
+		}
+	};
+
+	/**
+	* @brief EntityのBoxCollider、CircleCollider、LineColliderをすべて囲む矩形を求めます
+	* @return bool コライダーを1つも持っていなければfalse
+	*/
+	[[nodiscard]] inline bool GetColliderBounds(const Entity& entity, AABB& bounds)
+	{
+		bool hasBounds = false;
+		const auto merge = [&](const AABB& b)
+		{
+			bounds = hasBounds ? AABB::Merge(bounds, b) : b;
+			hasBounds = true;
+		};
+		if (entity.hasComponent<BoxCollider>())
+		{
+			const auto& box = entity.getComponent<BoxCollider>();
+			merge(AABB(Vec2(box.x(), box.y()), Vec2(box.x() + box.w(), box.y() + box.h())));
+		}
+		if (entity.hasComponent<CircleCollider>())
+		{
+			const auto& circle = entity.getComponent<CircleCollider>();
+			merge(AABB(Vec2(circle.x() - circle.radius(), circle.y() - circle.radius()),
+				Vec2(circle.x() + circle.radius(), circle.y() + circle.radius())));
+		}
+		if (entity.hasComponent<LineCollider>())
+		{
+			const auto& line = entity.getComponent<LineCollider>();
+			const Vec2 p1 = line.getStartPosition();
+			const Vec2 p2 = line.getEndPosition();
+			merge(AABB(Vec2((std::min)(p1.x, p2.x), (std::min)(p1.y, p2.y)), Vec2((std::max)(p1.x, p2.x), (std::max)(p1.y, p2.y))));
+		}
+		return hasBounds;
+	}
+
+	/**
+	* @brief コライダーを持つ生きているEntityと、そのコライダーを囲む矩形を1体ずつ渡します
+	* @param func void(Entity&, const AABB&)の関数
+	* @details 複数のコライダーを持つEntityも1度だけ渡されます
+	*/
+	template <typename Func> void EachColliderBounds(EntityManager& manager, Func&& func)
+	{
+		AABB bounds;
+		const auto each = [&](const ComponentID id, const auto& skip)
+		{
+			for (const auto& e : manager.getComponentPool(id).getEntities())
+			{
+				if (e->isActive() && !skip(*e) && GetColliderBounds(*e, bounds))
+				{
+					func(*e, bounds);
+				}
+			}
+		};
+		each(GetComponentTypeID<BoxCollider>(), [](const Entity&) { return false; });
+		each(GetComponentTypeID<CircleCollider>(), [](const Entity& e) { return e.hasComponent<BoxCollider>(); });
+		each(GetComponentTypeID<LineCollider>(), [](const Entity& e)
+		{
+			return e.hasComponent<BoxCollider>() || e.hasComponent<CircleCollider>();
+		});
+	}
+
+	/**
+	* @brief ブロードフェーズがEntityのハンドルから自分のプロキシを引くための表です
+	* @details Entityの番号で引く疎な配列に、プロキシの番号とハンドル、最後に登録したフレームを持ちます
+	* - 番号が同じでも世代が違うハンドルは、番号を再利用した別のEntityとして古いプロキシを外させます
+	* - 毎フレームbeginFrame()の後にすべてのEntityをtouch()し、sweep()で登録されなかったプロキシを外させます
+	* @tparam Index プロキシの番号の型。NONEは-1です
+	*/
+	template <typename Index>
+	class ProxyTable final
+	{
+	public:
+		static constexpr Index NONE = static_cast<Index>(-1);
+	private:
+		struct Slot
+		{
+			EntityId id;
+			Index proxy = NONE;
+			std::uint32_t frame = 0;
+		};
+		std::vector<Slot> slots_;
+		std::uint32_t frame_ = 0;
+	public:
+		//!Entityのプロキシを返します。登録されていなければNONEが返ります
+		[[nodiscard]] Index find(const EntityId& id) const noexcept
+		{
+			if (id.index >= slots_.size() || slots_[id.index].id != id)
+			{
+				return NONE;
+			}
+			return slots_[id.index].proxy;
+		}
+		/**
+		* @brief Entityのプロキシを返し、今のフレームで登録されたことを記録します
+		* @param onStale 番号を再利用した別のEntityのプロキシが残っていた場合に、それを外すvoid(Index)の関数
+		* @return Index 登録されていなければNONE。新しく作ったプロキシはinsert()で結び付けます
+		*/
+		template <typename Func> Index touch(const EntityId& id, Func&& onStale)
+		{
+			if (id.index >= slots_.size())
+			{
+				slots_.resize(id.index + 1);
+			}
+			auto& slot = slots_[id.index];
+			if (slot.proxy != NONE && slot.id != id)
+			{
+				const Index stale = slot.proxy;
+				slot.proxy = NONE;
+				onStale(stale);
+			}
+			slot.id = id;
+			slot.frame = frame_;
+			return slot.proxy;
+		}
+		//!touch()したEntityにプロキシを結び付けます
+		void insert(const EntityId& id, const Index proxy) noexcept
+		{
+			slots_[id.index].proxy = proxy;
+		}
+		//!Entityとプロキシの結び付きを外し、外したプロキシを返します。登録されていなければNONEが返ります
+		Index erase(const EntityId& id) noexcept
+		{
+			const Index proxy = find(id);
+			if (proxy != NONE)
+			{
+				slots_[id.index].proxy = NONE;
+			}
+			return proxy;
+		}
+		//!フレームを進めます。登録し直す前に呼びます
+		void beginFrame() noexcept
+		{
+			++frame_;
+		}
+		/**
+		* @brief 今のフレームでtouch()されなかったプロキシの結び付きを外します
+		* @param func 外したプロキシを受け取るvoid(Index)の関数
+		*/
+		template <typename Func> void sweep(Func&& func)
+		{
+			for (auto& slot : slots_)
+			{
+				if (slot.proxy != NONE && slot.frame != frame_)
+				{
+					const Index proxy = slot.proxy;
+					slot.proxy = NONE;
+					func(proxy);
+				}
+			}
+		}
+		//!結び付きをすべて外します
+		void clear() noexcept
+		{
+			slots_.clear();
+		}
+	};
+}
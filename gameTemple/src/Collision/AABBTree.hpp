@@ -0,0 +1,461 @@
+﻿/**
+* @file AABBTree.hpp
+* @brief コライダーの矩形を木構造で管理するブロードフェーズです
+* @author agent
+* @date 2026/10/17
+*/
+#pragma once
+#include "AABB.hpp"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+namespace ECS
+{
+	/**
+	* @brief コライダーの矩形を葉に持つ動的な二分木(BVH)です
+	* @details 葉には実際の矩形をmarginだけ広げた矩形を登録するので、少しの移動では木を組み替えません
+	* - 挿入と削除では回転で木の高さを揃えるので、検索のコストは登録数の対数に比例し、ワールドの広さには依存しません
+	* - 大きさの違うコライダーが混在していても性能が落ちにくいので、グリッドが向かない場面に使います
+	*/
+	class AABBTree final
+	{
+	private:
+		static constexpr std::int32_t NONE = -1;
+		struct Node
+		{
+			//!葉は広げた矩形、節は子を囲む矩形
+			AABB fat;
+			//!葉の実際の矩形
+			AABB bounds;
+			Entity* entity = nullptr;
+			//!使われていないノードでは次の空きノードを指す
+			std::int32_t parent = NONE;
+			std::int32_t child1 = NONE;
+			std::int32_t child2 = NONE;
+			//!葉は0、使われていないノードは-1
+			std::int32_t height = -1;
+			[[nodiscard]] bool isLeaf() const noexcept { return child1 == NONE; }
+		};
+		std::vector<Node> nodes_;
+		std::int32_t root_ = NONE;
+		std::int32_t freeList_ = NONE;
+		std::size_t leafCount_ = 0;
+		float margin_;
+		//!葉のノード番号をプロキシの番号として使う
+		ProxyTable<std::int32_t> table_;
+		std::vector<std::int32_t> stack_;
+
+		std::int32_t allocateNode()
+		{
+			if (freeList_ == NONE)
+			{
+				nodes_.emplace_back();
+				nodes_.back().height = 0;
+				return static_cast<std::int32_t>(nodes_.size() - 1);
+			}
+			const std::int32_t node = freeList_;
+			freeList_ = nodes_[node].parent;
+			nodes_[node] = Node{};
+			nodes_[node].height = 0;
+			return node;
+		}
+		void freeNode(const std::int32_t node) noexcept
+		{
+			nodes_[node].parent = freeList_;
+			nodes_[node].entity = nullptr;
+			nodes_[node].height = -1;
+			freeList_ = node;
+		}
+		void refit(const std::int32_t node) noexcept
+		{
+			auto& n = nodes_[node];
+			n.height = 1 + (std::max)(nodes_[n.child1].height, nodes_[n.child2].height);
+			n.fat = AABB::Merge(nodes_[n.child1].fat, nodes_[n.child2].fat);
+		}
+		void replaceChild(const std::int32_t parent, const std::int32_t oldChild, const std::int32_t newChild) noexcept
+		{
+			if (parent == NONE)
+			{
+				root_ = newChild;
+			}
+			else if (nodes_[parent].child1 == oldChild)
+			{
+				nodes_[parent].child1 = newChild;
+			}
+			else
+			{
+				nodes_[parent].child2 = newChild;
+			}
+		}
+		/**
+		* @brief 子の高さの差が2以上あれば回転して揃えます
+		* @return std::int32_t 回転後にその位置に来たノード
+		*/
+		std::int32_t balance(const std::int32_t iA) noexcept
+		{
+			Node& A = nodes_[iA];
+			if (A.isLeaf() || A.height < 2)
+			{
+				return iA;
+			}
+			const std::int32_t iB = A.child1;
+			const std::int32_t iC = A.child2;
+			Node& B = nodes_[iB];
+			Node& C = nodes_[iC];
+			const std::int32_t diff = C.height - B.height;
+			//Cを持ち上げる
+			if (diff > 1)
+			{
+				const std::int32_t iF = C.child1;
+				const std::int32_t iG = C.child2;
+				Node& F = nodes_[iF];
+				Node& G = nodes_[iG];
+				C.child1 = iA;
+				C.parent = A.parent;
+				A.parent = iC;
+				replaceChild(C.parent, iA, iC);
+				if (F.height > G.height)
+				{
+					C.child2 = iF;
+					A.child2 = iG;
+					G.parent = iA;
+				}
+				else
+				{
+					C.child2 = iG;
+					A.child2 = iF;
+					F.parent = iA;
+				}
+				refit(iA);
+				refit(iC);
+				return iC;
+			}
+			//Bを持ち上げる
+			if (diff < -1)
+			{
+				const std::int32_t iD = B.child1;
+				const std::int32_t iE = B.child2;
+				Node& D = nodes_[iD];
+				Node& E = nodes_[iE];
+				B.child1 = iA;
+				B.parent = A.parent;
+				A.parent = iB;
+				replaceChild(B.parent, iA, iB);
+				if (D.height > E.height)
+				{
+					B.child2 = iD;
+					A.child1 = iE;
+					E.parent = iA;
+				}
+				else
+				{
+					B.child2 = iE;
+					A.child1 = iD;
+					D.parent = iA;
+				}
+				refit(iA);
+				refit(iB);
+				return iB;
+			}
+			return iA;
+		}
+		//!葉から根までの矩形と高さを直し、必要なら回転します
+		void fixUpward(std::int32_t node) noexcept
+		{
+			while (node != NONE)
+			{
+				node = balance(node);
+				refit(node);
+				node = nodes_[node].parent;
+			}
+		}
+		void insertLeaf(const std::int32_t leaf)
+		{
+			if (root_ == NONE)
+			{
+				root_ = leaf;
+				nodes_[leaf].parent = NONE;
+				return;
+			}
+			//周長の増え方が最も小さくなる兄弟を探す
+			const AABB leafFat = nodes_[leaf].fat;
+			std::int32_t index = root_;
+			while (!nodes_[index].isLeaf())
+			{
+				const Node& n = nodes_[index];
+				const float area = n.fat.perimeter();
+				const float combinedArea = AABB::Merge(n.fat, leafFat).perimeter();
+				const float cost = 2.f * combinedArea;
+				const float inheritanceCost = 2.f * (combinedArea - area);
+				const auto childCost = [&](const std::int32_t child)
+				{
+					const Node& c = nodes_[child];
+					const float merged = AABB::Merge(leafFat, c.fat).perimeter();
+					return (c.isLeaf() ? merged : merged - c.fat.perimeter()) + inheritanceCost;
+				};
+				const float cost1 = childCost(n.child1);
+				const float cost2 = childCost(n.child2);
+				if (cost < cost1 && cost < cost2)
+				{
+					break;
+				}
+				index = cost1 < cost2 ? n.child1 : n.child2;
+			}
+			const std::int32_t sibling = index;
+			const std::int32_t newParent = allocateNode();
+			const std::int32_t oldParent = nodes_[sibling].parent;
+			nodes_[newParent].parent = oldParent;
+			nodes_[newParent].child1 = sibling;
+			nodes_[newParent].child2 = leaf;
+			replaceChild(oldParent, sibling, newParent);
+			nodes_[sibling].parent = newParent;
+			nodes_[leaf].parent = newParent;
+			fixUpward(newParent);
+		}
+		void removeLeaf(const std::int32_t leaf) noexcept
+		{
+			if (leaf == root_)
+			{
+				root_ = NONE;
+				return;
+			}
+			const std::int32_t parent = nodes_[leaf].parent;
+			const std::int32_t grandParent = nodes_[parent].parent;
+			const std::int32_t sibling = nodes_[parent].child1 == leaf ? nodes_[parent].child2 : nodes_[parent].child1;
+			replaceChild(grandParent, parent, sibling);
+			nodes_[sibling].parent = grandParent;
+			freeNode(parent);
+			fixUpward(grandParent);
+		}
+		//!葉を木から外して空きノードに戻します。表との結び付きは外してから呼びます
+		void removeProxy(const std::int32_t leaf) noexcept
+		{
+			removeLeaf(leaf);
+			freeNode(leaf);
+			--leafCount_;
+		}
+		/**
+		* @brief 線分p + d * t (0 <= t <= maxT)が矩形と交わるか判定します
+		* @param tEntry 矩形に入るときのt
+		*/
+		[[nodiscard]] static bool IntersectSegment(const AABB& box, const Vec2& p, const Vec2& d, const float maxT, float& tEntry) noexcept
+		{
+			float tMin = 0.f;
+			float tMax = maxT;
+			const float origin[2] = { p.x, p.y };
+			const float dir[2] = { d.x, d.y };
+			const float lower[2] = { box.lower.x, box.lower.y };
+			const float upper[2] = { box.upper.x, box.upper.y };
+			for (int axis = 0; axis < 2; ++axis)
+			{
+				if (std::abs(dir[axis]) < 1e-12f)
+				{
+					if (origin[axis] < lower[axis] || upper[axis] < origin[axis])
+					{
+						return false;
+					}
+					continue;
+				}
+				const float inv = 1.f / dir[axis];
+				float t1 = (lower[axis] - origin[axis]) * inv;
+				float t2 = (upper[axis] - origin[axis]) * inv;
+				if (t1 > t2)
+				{
+					std::swap(t1, t2);
+				}
+				tMin = (std::max)(tMin, t1);
+				tMax = (std::min)(tMax, t2);
+				if (tMin > tMax)
+				{
+					return false;
+				}
+			}
+			tEntry = tMin;
+			return true;
+		}
+	public:
+		//!葉の矩形を広げる幅を指定します。1フレームで動く距離程度にします
+		explicit AABBTree(const float margin = 4.f) :
+			margin_(margin)
+		{}
+
+		/**
+		* @brief Entityを指定した矩形で登録します。登録済みであれば矩形を更新します
+		* @details 広げた矩形からはみ出さなければ木は組み替えません
+		*/
+		void set(Entity& entity, const AABB& bounds)
+		{
+			const EntityId id = entity.getId();
+			std::int32_t leaf = table_.touch(id, [this](const std::int32_t stale) { removeProxy(stale); });
+			if (leaf != NONE)
+			{
+				auto& n = nodes_[leaf];
+				n.bounds = bounds;
+				if (n.fat.contains(bounds))
+				{
+					return;
+				}
+				removeLeaf(leaf);
+				n.fat = bounds.expanded(margin_);
+				insertLeaf(leaf);
+				return;
+			}
+			leaf = allocateNode();
+			auto& n = nodes_[leaf];
+			n.entity = &entity;
+			n.bounds = bounds;
+			n.fat = bounds.expanded(margin_);
+			table_.insert(id, leaf);
+			++leafCount_;
+			insertLeaf(leaf);
+		}
+		//!Entityの登録を外します
+		void remove(const EntityId& id) noexcept
+		{
+			const std::int32_t leaf = table_.erase(id);
+			if (leaf != NONE)
+			{
+				removeProxy(leaf);
+			}
+		}
+		/**
+		* @brief マネージャー内のコライダーを持つEntityをすべて登録し直します
+		* @details コライダーがなくなったEntityや死んだEntityは登録から外れます
+		* - refresh()で破棄されたEntityはここで外れるので、refresh()の後、判定の前に毎フレーム呼びます
+		*/
+		void update(EntityManager& manager)
+		{
+			table_.beginFrame();
+			EachColliderBounds(manager, [this](Entity& e, const AABB& bounds) { set(e, bounds); });
+			table_.sweep([this](const std::int32_t leaf) { removeProxy(leaf); });
+		}
+		/**
+		* @brief 矩形と重なっているEntityをすべて渡します
+		* @param func void(Entity&)の関数
+		*/
+		template <typename Func> void query(const AABB& bounds, Func&& func)
+		{
+			if (root_ == NONE)
+			{
+				return;
+			}
+			stack_.clear();
+			stack_.emplace_back(root_);
+			while (!stack_.empty())
+			{
+				const Node& n = nodes_[stack_.back()];
+				stack_.pop_back();
+				if (!n.fat.overlaps(bounds))
+				{
+					continue;
+				}
+				if (n.isLeaf())
+				{
+					if (n.bounds.overlaps(bounds))
+					{
+						func(*n.entity);
+					}
+					continue;
+				}
+				stack_.emplace_back(n.child1);
+				stack_.emplace_back(n.child2);
+			}
+		}
+		//!点を含むEntityをすべて渡します
+		template <typename Func> void query(const Vec2& point, Func&& func)
+		{
+			query(AABB(point, point), std::forward<Func>(func));
+		}
+		/**
+		* @brief 矩形が重なっているEntityのペアをすべて渡します
+		* @param func void(Entity&, Entity&)の関数
+		* @details 葉ごとに木を検索するので、コストは登録数 * log(登録数)に比例します
+		*/
+		template <typename Func> void findPairs(Func&& func)
+		{
+			std::vector<std::int32_t> stack;
+			for (std::int32_t i = 0; i < static_cast<std::int32_t>(nodes_.size()); ++i)
+			{
+				const Node& leaf = nodes_[i];
+				if (leaf.height != 0 || leaf.entity == nullptr)
+				{
+					continue;
+				}
+				stack.clear();
+				stack.emplace_back(root_);
+				while (!stack.empty())
+				{
+					const std::int32_t index = stack.back();
+					stack.pop_back();
+					const Node& n = nodes_[index];
+					if (!n.fat.overlaps(leaf.bounds))
+					{
+						continue;
+					}
+					if (n.isLeaf())
+					{
+						//同じペアを2回報告しないよう、番号の大きい方だけを相手にする
+						if (index > i && n.bounds.overlaps(leaf.bounds))
+						{
+							func(*leaf.entity, *n.entity);
+						}
+						continue;
+					}
+					stack.emplace_back(n.child1);
+					stack.emplace_back(n.child2);
+				}
+			}
+		}
+		/**
+		* @brief 線分と矩形が交わるEntityを渡します
+		* @param func bool(Entity&, float t)の関数。tは線分上で矩形に入る位置の割合(0～1)です。falseを返すと打ち切ります
+		* @details 順番は距離順ではありません。最も近いものが必要な場合はtの小さいものを選んでください
+		*/
+		template <typename Func> void raycast(const Vec2& from, const Vec2& to, Func&& func)
+		{
+			if (root_ == NONE)
+			{
+				return;
+			}
+			const Vec2 d(to.x - from.x, to.y - from.y);
+			float t = 0.f;
+			stack_.clear();
+			stack_.emplace_back(root_);
+			while (!stack_.empty())
+			{
+				const Node& n = nodes_[stack_.back()];
+				stack_.pop_back();
+				if (!IntersectSegment(n.fat, from, d, 1.f, t))
+				{
+					continue;
+				}
+				if (n.isLeaf())
+				{
+					if (IntersectSegment(n.bounds, from, d, 1.f, t) && !func(*n.entity, t))
+					{
+						return;
+					}
+					continue;
+				}
+				stack_.emplace_back(n.child1);
+				stack_.emplace_back(n.child2);
+			}
+		}
+		//!登録されているEntityの数を返します
+		[[nodiscard]] std::size_t size() const noexcept { return leafCount_; }
+		//!木の高さを返します。葉だけなら0です
+		[[nodiscard]] std::int32_t getHeight() const noexcept { return root_ == NONE ? 0 : nodes_[root_].height; }
+		//!葉の矩形を広げる幅を返します
+		[[nodiscard]] float getMargin() const noexcept { return margin_; }
+		//!登録をすべて外します
+		void clear()
+		{
+			nodes_.clear();
+			table_.clear();
+			root_ = NONE;
+			freeList_ = NONE;
+			leafCount_ = 0;
+		}
+	};
+}
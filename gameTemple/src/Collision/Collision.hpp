@@ -170,8 +170,8 @@ public:
 		const auto& point = e2->getComponent<T2>();
 
 		Vec2 buttonPos = Vec2(circle.x(), circle.y());
-		Vec2 distance = buttonPos - point.val();
-		if (distance.Length() <= circle.radius())
+		Vec2 distance = buttonPos - point.val;
+		if (distance.length() <= circle.radius())
 		{
 			return true;
 		}
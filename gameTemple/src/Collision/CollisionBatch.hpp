@@ -0,0 +1,369 @@
+﻿/**
+* @file CollisionBatch.hpp
+* @brief Collision2Dの判定を複数のペアにまとめて行うSIMD版です
+* @author agent
+* @date 2026/10/17
+*/
+#pragma once
+#include "../ECS/ECS.hpp"
+#include "../Components/BasicComponents.hpp"
+#include "../Components/Collider.hpp"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+* @brief Collision2Dの判定を、配列に並べた候補のペアに対してまとめて行うクラスです
+* -メソッドはすべてstaticです
+* -ペアは座標や大きさを要素ごとの配列(SoA)に並べ、AVX2なら8組、SSE2なら4組ずつ判定します
+* -結果はペアを追加した順番のビット列で返します。どのEntityのペアかは呼び出し側で同じ順番の配列を持ってください
+* -SIMDの幅に満たない余りとSIMDが使えない環境では、同じ式を1組ずつ計算します
+* -演算の順番と比較の種類はCollision2Dと同じなので、結果はCollision2Dと完全に一致します(コンパイラにFMAへの縮約をさせない場合)
+*/
+class Collision2DBatch
+{
+public:
+	//!判定結果をペアごとに1bitで持つビット列です
+	class HitMask final
+	{
+	private:
+		std::vector<std::uint64_t> words_;
+		std::size_t size_ = 0;
+		friend class Collision2DBatch;
+		void reset(const std::size_t size)
+		{
+			size_ = size;
+			words_.assign((size + 63) / 64, 0u);
+		}
+		void setBits(const std::size_t pos, const std::uint64_t bits) noexcept
+		{
+			words_[pos / 64] |= bits << (pos % 64);
+		}
+		[[nodiscard]] static std::size_t CountTrailingZero(const std::uint64_t word) noexcept
+		{
+#if defined(_MSC_VER) && defined(_M_X64)
+			unsigned long index;
+			_BitScanForward64(&index, word);
+			return index;
+#elif defined(__GNUC__)
+			return static_cast<std::size_t>(__builtin_ctzll(word));
+#else
+			std::size_t index = 0;
+			for (std::uint64_t w = word; (w & 1u) == 0u; w >>= 1)
+			{
+				++index;
+			}
+			return index;
+#endif
+		}
+	public:
+		//!ペアの数を返します
+		[[nodiscard]] std::size_t size() const noexcept { return size_; }
+		//!指定したペアが当たっているか返します
+		[[nodiscard]] bool test(const std::size_t pos) const noexcept
+		{
+			return (words_[pos / 64] >> (pos % 64) & 1u) != 0u;
+		}
+		//!当たっているペアの数を返します
+		[[nodiscard]] std::size_t count() const noexcept
+		{
+			std::size_t num = 0;
+			for (auto w : words_)
+			{
+				for (; w != 0u; w &= w - 1)
+				{
+					++num;
+				}
+			}
+			return num;
+		}
+		/**
+		* @brief 当たっているペアの番号を小さい順に渡します
+		* @param func void(std::size_t)の関数
+		*/
+		template <typename Func> void each(Func&& func) const
+		{
+			for (std::size_t i = 0; i < words_.size(); ++i)
+			{
+				for (std::uint64_t w = words_[i]; w != 0u; w &= w - 1)
+				{
+					func(i * 64 + CountTrailingZero(w));
+				}
+			}
+		}
+		//!64ペアごとのワードを返します
+		[[nodiscard]] const std::vector<std::uint64_t>& getWords() const noexcept { return words_; }
+	};
+
+	//!矩形と矩形のペアの配列です
+	struct BoxPairs final
+	{
+		std::vector<float> x1, y1, w1, h1, x2, y2, w2, h2;
+		//!IBoxColliderから値を取り出して追加します
+		void add(const ECS::IBoxCollider& b1, const ECS::IBoxCollider& b2)
+		{
+			add(Vec2(b1.x(), b1.y()), Vec2(b1.w(), b1.h()), Vec2(b2.x(), b2.y()), Vec2(b2.w(), b2.h()));
+		}
+		void add(const Vec2& b1Pos, const Vec2& b1Size, const Vec2& b2Pos, const Vec2& b2Size)
+		{
+			x1.emplace_back(b1Pos.x); y1.emplace_back(b1Pos.y); w1.emplace_back(b1Size.x); h1.emplace_back(b1Size.y);
+			x2.emplace_back(b2Pos.x); y2.emplace_back(b2Pos.y); w2.emplace_back(b2Size.x); h2.emplace_back(b2Size.y);
+		}
+		[[nodiscard]] std::size_t size() const noexcept { return x1.size(); }
+		void reserve(const std::size_t size)
+		{
+			for (auto* v : { &x1, &y1, &w1, &h1, &x2, &y2, &w2, &h2 }) { v->reserve(size); }
+		}
+		//!ペアを空にします。確保したメモリはそのまま再利用します
+		void clear() noexcept
+		{
+			for (auto* v : { &x1, &y1, &w1, &h1, &x2, &y2, &w2, &h2 }) { v->clear(); }
+		}
+	};
+
+	//!円と円のペアの配列です
+	struct CirclePairs final
+	{
+		std::vector<float> x1, y1, r1, x2, y2, r2;
+		//!ICircleColliderから値を取り出して追加します
+		void add(const ECS::ICircleCollider& c1, const ECS::ICircleCollider& c2)
+		{
+			add(Vec2(c1.x(), c1.y()), c1.radius(), Vec2(c2.x(), c2.y()), c2.radius());
+		}
+		void add(const Vec2& c1Pos, const float c1r, const Vec2& c2Pos, const float c2r)
+		{
+			x1.emplace_back(c1Pos.x); y1.emplace_back(c1Pos.y); r1.emplace_back(c1r);
+			x2.emplace_back(c2Pos.x); y2.emplace_back(c2Pos.y); r2.emplace_back(c2r);
+		}
+		[[nodiscard]] std::size_t size() const noexcept { return x1.size(); }
+		void reserve(const std::size_t size)
+		{
+			for (auto* v : { &x1, &y1, &r1, &x2, &y2, &r2 }) { v->reserve(size); }
+		}
+		//!ペアを空にします。確保したメモリはそのまま再利用します
+		void clear() noexcept
+		{
+			for (auto* v : { &x1, &y1, &r1, &x2, &y2, &r2 }) { v->clear(); }
+		}
+	};
+
+	//!円と矩形のペアの配列です
+	struct CircleBoxPairs final
+	{
+		std::vector<float> cx, cy, r, bx, by, bw, bh;
+		//!ICircleColliderとIBoxColliderから値を取り出して追加します
+		void add(const ECS::ICircleCollider& c, const ECS::IBoxCollider& b)
+		{
+			add(Vec2(c.x(), c.y()), c.radius(), Vec2(b.x(), b.y()), Vec2(b.w(), b.h()));
+		}
+		void add(const Vec2& circlePos, const float radius, const Vec2& boxPos, const Vec2& boxSize)
+		{
+			cx.emplace_back(circlePos.x); cy.emplace_back(circlePos.y); r.emplace_back(radius);
+			bx.emplace_back(boxPos.x); by.emplace_back(boxPos.y); bw.emplace_back(boxSize.x); bh.emplace_back(boxSize.y);
+		}
+		[[nodiscard]] std::size_t size() const noexcept { return cx.size(); }
+		void reserve(const std::size_t size)
+		{
+			for (auto* v : { &cx, &cy, &r, &bx, &by, &bw, &bh }) { v->reserve(size); }
+		}
+		//!ペアを空にします。確保したメモリはそのまま再利用します
+		void clear() noexcept
+		{
+			for (auto* v : { &cx, &cy, &r, &bx, &by, &bw, &bh }) { v->clear(); }
+		}
+	};
+
+	//!線分と線分のペアの配列です
+	struct LinePairs final
+	{
+		std::vector<float> x1, y1, x2, y2, x3, y3, x4, y4;
+		//!l1は(x1, y1)-(x2, y2)、l2は(x3, y3)-(x4, y4)に入ります
+		void add(const ECS::LineData2D& l1, const ECS::LineData2D& l2)
+		{
+			x1.emplace_back(l1.p1.x); y1.emplace_back(l1.p1.y); x2.emplace_back(l1.p2.x); y2.emplace_back(l1.p2.y);
+			x3.emplace_back(l2.p1.x); y3.emplace_back(l2.p1.y); x4.emplace_back(l2.p2.x); y4.emplace_back(l2.p2.y);
+		}
+		[[nodiscard]] std::size_t size() const noexcept { return x1.size(); }
+		void reserve(const std::size_t size)
+		{
+			for (auto* v : { &x1, &y1, &x2, &y2, &x3, &y3, &x4, &y4 }) { v->reserve(size); }
+		}
+		//!ペアを空にします。確保したメモリはそのまま再利用します
+		void clear() noexcept
+		{
+			for (auto* v : { &x1, &y1, &x2, &y2, &x3, &y3, &x4, &y4 }) { v->clear(); }
+		}
+	};
+
+private:
+	//!1組ずつ計算するレーンです
+	struct ScalarLane
+	{
+		using Float = float;
+		using Mask = bool;
+		static constexpr std::size_t Width = 1;
+		static Float Load(const float* p) noexcept { return *p; }
+		static Float Zero() noexcept { return 0.f; }
+		static Float Add(const Float a, const Float b) noexcept { return a + b; }
+		static Float Sub(const Float a, const Float b) noexcept { return a - b; }
+		static Float Mul(const Float a, const Float b) noexcept { return a * b; }
+		static Mask Less(const Float a, const Float b) noexcept { return a < b; }
+		static Mask LessEqual(const Float a, const Float b) noexcept { return a <= b; }
+		static Mask Greater(const Float a, const Float b) noexcept { return a > b; }
+		static Mask And(const Mask a, const Mask b) noexcept { return a && b; }
+		static Mask Or(const Mask a, const Mask b) noexcept { return a || b; }
+		static Mask Not(const Mask a) noexcept { return !a; }
+		static std::uint64_t Bits(const Mask a) noexcept { return a ? 1u : 0u; }
+	};
+#if defined(__AVX2__)
+	//!AVX2で8組ずつ計算するレーンです
+	struct SimdLane
+	{
+		using Float = __m256;
+		using Mask = __m256;
+		static constexpr std::size_t Width = 8;
+		static Float Load(const float* p) noexcept { return _mm256_loadu_ps(p); }
+		static Float Zero() noexcept { return _mm256_setzero_ps(); }
+		static Float Add(const Float& a, const Float& b) noexcept { return _mm256_add_ps(a, b); }
+		static Float Sub(const Float& a, const Float& b) noexcept { return _mm256_sub_ps(a, b); }
+		static Float Mul(const Float& a, const Float& b) noexcept { return _mm256_mul_ps(a, b); }
+		static Mask Less(const Float& a, const Float& b) noexcept { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		static Mask LessEqual(const Float& a, const Float& b) noexcept { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+		static Mask Greater(const Float& a, const Float& b) noexcept { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+		static Mask And(const Mask& a, const Mask& b) noexcept { return _mm256_and_ps(a, b); }
+		static Mask Or(const Mask& a, const Mask& b) noexcept { return _mm256_or_ps(a, b); }
+		static Mask Not(const Mask& a) noexcept { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+		static std::uint64_t Bits(const Mask& a) noexcept { return static_cast<std::uint64_t>(_mm256_movemask_ps(a)); }
+	};
+#elif defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	//!SSEで4組ずつ計算するレーンです
+	struct SimdLane
+	{
+		using Float = __m128;
+		using Mask = __m128;
+		static constexpr std::size_t Width = 4;
+		static Float Load(const float* p) noexcept { return _mm_loadu_ps(p); }
+		static Float Zero() noexcept { return _mm_setzero_ps(); }
+		static Float Add(const Float& a, const Float& b) noexcept { return _mm_add_ps(a, b); }
+		static Float Sub(const Float& a, const Float& b) noexcept { return _mm_sub_ps(a, b); }
+		static Float Mul(const Float& a, const Float& b) noexcept { return _mm_mul_ps(a, b); }
+		static Mask Less(const Float& a, const Float& b) noexcept { return _mm_cmplt_ps(a, b); }
+		static Mask LessEqual(const Float& a, const Float& b) noexcept { return _mm_cmple_ps(a, b); }
+		static Mask Greater(const Float& a, const Float& b) noexcept { return _mm_cmpgt_ps(a, b); }
+		static Mask And(const Mask& a, const Mask& b) noexcept { return _mm_and_ps(a, b); }
+		static Mask Or(const Mask& a, const Mask& b) noexcept { return _mm_or_ps(a, b); }
+		static Mask Not(const Mask& a) noexcept { return _mm_xor_ps(a, _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps())); }
+		static std::uint64_t Bits(const Mask& a) noexcept { return static_cast<std::uint64_t>(_mm_movemask_ps(a)); }
+	};
+#else
+	using SimdLane = ScalarLane;
+#endif
+
+	template <class L> static typename L::Mask BoxAndBoxKernel(const BoxPairs& p, const std::size_t i) noexcept
+	{
+		const auto x1 = L::Load(&p.x1[i]), y1 = L::Load(&p.y1[i]), w1 = L::Load(&p.w1[i]), h1 = L::Load(&p.h1[i]);
+		const auto x2 = L::Load(&p.x2[i]), y2 = L::Load(&p.y2[i]), w2 = L::Load(&p.w2[i]), h2 = L::Load(&p.h2[i]);
+		return L::And(
+			L::And(L::Less(x1, L::Add(x2, w2)), L::Less(x2, L::Add(x1, w1))),
+			L::And(L::Less(y1, L::Add(y2, h2)), L::Less(y2, L::Add(y1, h1))));
+	}
+	template <class L> static typename L::Mask CircleAndCircleKernel(const CirclePairs& p, const std::size_t i) noexcept
+	{
+		const auto dx = L::Sub(L::Load(&p.x1[i]), L::Load(&p.x2[i]));
+		const auto dy = L::Sub(L::Load(&p.y1[i]), L::Load(&p.y2[i]));
+		const auto r = L::Add(L::Load(&p.r1[i]), L::Load(&p.r2[i]));
+		return L::LessEqual(L::Add(L::Mul(dx, dx), L::Mul(dy, dy)), L::Mul(r, r));
+	}
+	template <class L> static typename L::Mask CircleAndBoxKernel(const CircleBoxPairs& p, const std::size_t i) noexcept
+	{
+		const auto cx = L::Load(&p.cx[i]), cy = L::Load(&p.cy[i]), r = L::Load(&p.r[i]);
+		const auto bx = L::Load(&p.bx[i]), by = L::Load(&p.by[i]), bw = L::Load(&p.bw[i]), bh = L::Load(&p.bh[i]);
+		//外れる条件のどれにも当てはまらなければ当たり(NaNの扱いもCollision2Dと同じになる)
+		const auto miss = L::Or(
+			L::Or(L::LessEqual(L::Add(cx, r), bx), L::LessEqual(L::Add(cy, r), by)),
+			L::Or(L::LessEqual(L::Add(bx, bw), L::Sub(cx, r)), L::LessEqual(L::Add(by, bh), L::Sub(cy, r))));
+		return L::Not(miss);
+	}
+	//!baseを基準に2点が同じ側にあれば(外積の積が正なら)真を返します
+	template <class L> static typename L::Mask SameSide(
+		const typename L::Float& baseX, const typename L::Float& baseY,
+		const typename L::Float& sub1X, const typename L::Float& sub1Y,
+		const typename L::Float& sub2X, const typename L::Float& sub2Y) noexcept
+	{
+		const auto bs1 = L::Sub(L::Mul(baseX, sub1Y), L::Mul(baseY, sub1X));
+		const auto bs2 = L::Sub(L::Mul(baseX, sub2Y), L::Mul(baseY, sub2X));
+		return L::Greater(L::Mul(bs1, bs2), L::Zero());
+	}
+	template <class L> static typename L::Mask LineAndLineKernel(const LinePairs& p, const std::size_t i) noexcept
+	{
+		const auto x1 = L::Load(&p.x1[i]), y1 = L::Load(&p.y1[i]), x2 = L::Load(&p.x2[i]), y2 = L::Load(&p.y2[i]);
+		const auto x3 = L::Load(&p.x3[i]), y3 = L::Load(&p.y3[i]), x4 = L::Load(&p.x4[i]), y4 = L::Load(&p.y4[i]);
+		const auto miss1 = SameSide<L>(L::Sub(x4, x3), L::Sub(y4, y3), L::Sub(x1, x3), L::Sub(y1, y3), L::Sub(x2, x3), L::Sub(y2, y3));
+		const auto miss2 = SameSide<L>(L::Sub(x2, x1), L::Sub(y2, y1), L::Sub(x3, x1), L::Sub(y3, y1), L::Sub(x4, x1), L::Sub(y4, y1));
+		return L::Not(L::Or(miss1, miss2));
+	}
+	//!SIMDの幅ずつ判定し、余りを1組ずつ判定します
+	template <class Pairs, class SimdKernel, class ScalarKernel>
+	static void Run(const Pairs& pairs, HitMask& hits, SimdKernel&& simdKernel, ScalarKernel&& scalarKernel)
+	{
+		const std::size_t count = pairs.size();
+		hits.reset(count);
+		std::size_t i = 0;
+		for (; i + SimdLane::Width <= count; i += SimdLane::Width)
+		{
+			hits.setBits(i, SimdLane::Bits(simdKernel(pairs, i)));
+		}
+		for (; i < count; ++i)
+		{
+			hits.setBits(i, ScalarLane::Bits(scalarKernel(pairs, i)));
+		}
+	}
+public:
+	//!1回にまとめて判定するペアの数です
+	static constexpr std::size_t LANE_WIDTH = SimdLane::Width;
+
+	/**
+	* @brief 矩形と矩形のあたり判定をまとめて行います
+	* @param pairs 判定するペア
+	* @param hits 結果。当たっていればペアの番号のビットが立ちます
+	*/
+	static void BoxAndBox(const BoxPairs& pairs, HitMask& hits)
+	{
+		Run(pairs, hits, BoxAndBoxKernel<SimdLane>, BoxAndBoxKernel<ScalarLane>);
+	}
+	/**
+	* @brief 円と円のあたり判定をまとめて行います
+	* @param pairs 判定するペア
+	* @param hits 結果。当たっていればペアの番号のビットが立ちます
+	*/
+	static void CircleAndCircle(const CirclePairs& pairs, HitMask& hits)
+	{
+		Run(pairs, hits, CircleAndCircleKernel<SimdLane>, CircleAndCircleKernel<ScalarLane>);
+	}
+	/**
+	* @brief 円と矩形のあたり判定をまとめて行います
+	* @param pairs 判定するペア
+	* @param hits 結果。当たっていればペアの番号のビットが立ちます
+	*/
+	static void CircleAndBox(const CircleBoxPairs& pairs, HitMask& hits)
+	{
+		Run(pairs, hits, CircleAndBoxKernel<SimdLane>, CircleAndBoxKernel<ScalarLane>);
+	}
+	/**
+	* @brief 線分と線分の当たり判定をまとめて行います
+	* @param pairs 判定するペア
+	* @param hits 結果。当たっていればペアの番号のビットが立ちます
+	*/
+	static void LineAndLine(const LinePairs& pairs, HitMask& hits)
+	{
+		Run(pairs, hits, LineAndLineKernel<SimdLane>, LineAndLineKernel<ScalarLane>);
+	}
+};
@@ -0,0 +1,221 @@
+﻿/**
+* @file ContactCache.hpp
+* @brief 衝突するグループの組み合わせと、接触しているペアの変化を管理します
+* @author agent
+* @date 2026/10/17
+*/
+#pragma once
+#include "../ECS/ECS.hpp"
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+namespace ECS
+{
+	/**
+	* @brief どのグループ同士が衝突するかをグループ×グループの表で持つレイヤー設定です
+	* @details 行ごとに衝突する相手のグループをGroupBitSetで持つので、Entity同士の判定はビット列の共通部分の判定で済みます
+	* - どのグループにも登録されていないEntityは何とも衝突しません
+	*/
+	class CollisionLayers final
+	{
+	private:
+		std::array<GroupBitSet, MaxGroups> matrix_{};
+	public:
+		//!グループaとbが衝突するようにします
+		void enable(const Group& a, const Group& b) noexcept
+		{
+			matrix_[a].set(b);
+			matrix_[b].set(a);
+		}
+		//!グループaとbが衝突しないようにします
+		void disable(const Group& a, const Group& b) noexcept
+		{
+			matrix_[a].reset(b);
+			matrix_[b].reset(a);
+		}
+		//!グループaとbが衝突するか返します
+		[[nodiscard]] bool canCollide(const Group& a, const Group& b) const noexcept
+		{
+			return matrix_[a].test(b);
+		}
+		//!Entity同士の登録されているグループの中に、衝突する組み合わせがあるか返します
+		[[nodiscard]] bool canCollide(const Entity& a, const Entity& b) const noexcept
+		{
+			const GroupBitSet& groupsB = b.getGroups();
+			bool result = false;
+			a.getGroups().each([&](const std::size_t group)
+			{
+				result = result || matrix_[group].intersects(groupsB);
+			});
+			return result;
+		}
+		//!グループが衝突する相手のグループを返します
+		[[nodiscard]] const GroupBitSet& getMask(const Group& group) const noexcept { return matrix_[group]; }
+		//!すべての組み合わせを衝突しないようにします
+		void clear() noexcept
+		{
+			for (auto& it : matrix_)
+			{
+				it.reset();
+			}
+		}
+	};
+
+	//!ContactCacheが報告する接触しているペアです
+	struct Contact final
+	{
+		//!破棄されたEntityではnullptrになります
+		Entity* a;
+		Entity* b;
+		EntityId idA;
+		EntityId idB;
+	};
+
+	/**
+	* @brief 接触しているEntityのペアをフレームをまたいで保持し、接触の開始、継続、終了をまとめて報告します
+	* @details beginStep()の後にadd()で今のフレームに接触しているペアを登録し、endStep()で前のフレームと比べます
+	* - step()を使えば、ブロードフェーズの候補をレイヤーで絞り込んでから判定の関数に渡し、結果を登録するまでを1回で行えます
+	* - 続いているペアは同じ要素をそのまま使うので、メモリの確保は新しく接触したペアでしか起きません
+	* - ペアのEntityの順番は最初に登録したときのものが保たれます
+	*/
+	class ContactCache final
+	{
+	private:
+		struct Entry
+		{
+			Entity* a;
+			Entity* b;
+			EntityId idA;
+			EntityId idB;
+			std::uint32_t frame;
+			bool isNew;
+		};
+		std::vector<Entry> contacts_;
+		std::unordered_map<std::uint64_t, std::uint32_t> indices_;
+		std::vector<Contact> entered_;
+		std::vector<Contact> stayed_;
+		std::vector<Contact> exited_;
+		std::uint32_t frame_ = 0;
+
+		[[nodiscard]] static std::uint64_t Key(const EntityId& a, const EntityId& b) noexcept
+		{
+			return a.index < b.index ?
+				(static_cast<std::uint64_t>(a.index) << 32) | b.index :
+				(static_cast<std::uint64_t>(b.index) << 32) | a.index;
+		}
+		void pushExited(const Entry& entry, EntityManager& manager)
+		{
+			exited_.emplace_back(Contact{ manager.getEntity(entry.idA), manager.getEntity(entry.idB), entry.idA, entry.idB });
+		}
+	public:
+		//!フレームの判定を始めます。add()の前に呼びます
+		void beginStep() noexcept
+		{
+			exited_.clear();
+			++frame_;
+		}
+		/**
+		* @brief 今のフレームに接触しているペアを登録します
+		* @details 同じペアを何度登録しても1つとして扱います
+		*/
+		void add(Entity& a, Entity& b)
+		{
+			const EntityId idA = a.getId();
+			const EntityId idB = b.getId();
+			const auto result = indices_.emplace(Key(idA, idB), static_cast<std::uint32_t>(contacts_.size()));
+			if (result.second)
+			{
+				contacts_.emplace_back(Entry{ &a, &b, idA, idB, frame_, true });
+				return;
+			}
+			Entry& entry = contacts_[result.first->second];
+			const bool isSame = (entry.idA == idA && entry.idB == idB) || (entry.idA == idB && entry.idB == idA);
+			if (!isSame)
+			{
+				//番号を再利用した別のEntityとのペアなので、古いペアは終了したものとして入れ替える。古いペアの片方はまだ生きている場合がある
+				pushExited(entry, a.getManager());
+				entry = Entry{ &a, &b, idA, idB, frame_, true };
+				return;
+			}
+			entry.frame = frame_;
+		}
+		/**
+		* @brief 前のフレームと比べて、接触の開始、継続、終了を求めます
+		* @details 終了したペアのEntityが破棄されていればContactのポインタはnullptrになります
+		*/
+		void endStep(EntityManager& manager)
+		{
+			entered_.clear();
+			stayed_.clear();
+			for (std::uint32_t i = 0; i < contacts_.size();)
+			{
+				Entry& entry = contacts_[i];
+				if (entry.frame == frame_)
+				{
+					(entry.isNew ? entered_ : stayed_).emplace_back(Contact{ entry.a, entry.b, entry.idA, entry.idB });
+					entry.isNew = false;
+					++i;
+					continue;
+				}
+				pushExited(entry, manager);
+				indices_.erase(Key(entry.idA, entry.idB));
+				if (i + 1 != contacts_.size())
+				{
+					entry = contacts_.back();
+					indices_[Key(entry.idA, entry.idB)] = i;
+				}
+				contacts_.pop_back();
+			}
+		}
+		/**
+		* @brief ブロードフェーズの候補のうち、レイヤーで衝突するペアだけを判定し、接触の変化を求めます
+		* @param broadphase findPairs(void(Entity&, Entity&))を持つブロードフェーズ。SpatialHashGrid、AABBTree、SweepAndPruneが使えます
+		* @param layers 衝突するグループの組み合わせ
+		* @param isHit bool(Entity&, Entity&)の関数。Collision2Dなどで実際に当たっているか判定します
+		* @details レイヤーで衝突しないペアはisHitを呼びません
+		*/
+		template <typename Broadphase, typename Func>
+		void step(EntityManager& manager, Broadphase& broadphase, const CollisionLayers& layers, Func&& isHit)
+		{
+			beginStep();
+			broadphase.findPairs([&](Entity& a, Entity& b)
+			{
+				if (layers.canCollide(a, b) && isHit(a, b))
+				{
+					add(a, b);
+				}
+			});
+			endStep(manager);
+		}
+		//!直前のendStep()で接触し始めたペアを返します
+		[[nodiscard]] const std::vector<Contact>& getEntered() const noexcept { return entered_; }
+		//!直前のendStep()で前のフレームから接触し続けているペアを返します
+		[[nodiscard]] const std::vector<Contact>& getStayed() const noexcept { return stayed_; }
+		//!直前のendStep()で離れたペアを返します
+		[[nodiscard]] const std::vector<Contact>& getExited() const noexcept { return exited_; }
+		//!aとbが接触しているか返します
+		[[nodiscard]] bool isTouching(const Entity& a, const Entity& b) const
+		{
+			const auto it = indices_.find(Key(a.getId(), b.getId()));
+			if (it == indices_.end())
+			{
+				return false;
+			}
+			const Entry& entry = contacts_[it->second];
+			return (entry.idA == a.getId() && entry.idB == b.getId()) || (entry.idA == b.getId() && entry.idB == a.getId());
+		}
+		//!接触しているペアの数を返します
+		[[nodiscard]] std::size_t size() const noexcept { return contacts_.size(); }
+		//!すべてのペアを捨てます。離れたペアは報告しません
+		void clear()
+		{
+			contacts_.clear();
+			indices_.clear();
+			entered_.clear();
+			stayed_.clear();
+			exited_.clear();
+		}
+	};
+}
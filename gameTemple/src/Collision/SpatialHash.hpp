@@ -0,0 +1,268 @@
+﻿/**
+* @file SpatialHash.hpp
+* @brief 一様なグリッドでコライダーを分割するブロードフェーズです
+* @author agent
+* @date 2026/10/17
+*/
+#pragma once
+#include "AABB.hpp"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+
+namespace ECS
+{
+	/**
+	* @brief コライダーを一様なグリッドに登録し、衝突の候補を求める空間ハッシュです
+	* @details update()で毎フレームコライダーの矩形を登録し直し、findPairs()で候補のペアを、query()で範囲内のEntityを求めます
+	* - セルをまたいだ移動がなければセルへの登録はそのままなので、コストは移動したコライダーの数に比例します
+	* - 1つのペアは重なりの左上を含むセルでだけ報告するので、重複はありません
+	* - セルの大きさはコライダーの平均的な大きさの1～2倍程度にします。極端に大きなコライダーが多い場合はAABBTreeを使ってください
+	*/
+	class SpatialHashGrid final
+	{
+	private:
+		static constexpr std::uint32_t NONE = static_cast<std::uint32_t>(-1);
+		struct CellRange
+		{
+			std::int32_t minX, minY, maxX, maxY;
+			[[nodiscard]] bool operator==(const CellRange& other) const noexcept
+			{
+				return minX == other.minX && minY == other.minY && maxX == other.maxX && maxY == other.maxY;
+			}
+		};
+		struct Proxy
+		{
+			Entity* entity = nullptr;
+			AABB bounds;
+			//!登録しているセルの範囲。外すときはこの範囲のセルから消す
+			CellRange range{};
+			std::uint32_t queryStamp = 0;
+		};
+		float cellSize_;
+		float invCellSize_;
+		std::vector<Proxy> proxies_;
+		std::vector<std::uint32_t> freeProxies_;
+		ProxyTable<std::uint32_t> table_;
+		using Cells = std::unordered_map<std::uint64_t, std::vector<std::uint32_t>>;
+		Cells cells_;
+		//!findPairs()でセルをキーの順に並べるための作業領域
+		std::vector<const Cells::value_type*> sortedCells_;
+		std::uint32_t queryStamp_ = 0;
+
+		[[nodiscard]] static std::uint64_t Key(const std::int32_t x, const std::int32_t y) noexcept
+		{
+			return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) | static_cast<std::uint32_t>(y);
+		}
+		[[nodiscard]] std::int32_t toCell(const float v) const noexcept
+		{
+			return static_cast<std::int32_t>(std::floor(v * invCellSize_));
+		}
+		[[nodiscard]] CellRange toRange(const AABB& bounds) const noexcept
+		{
+			return CellRange{ toCell(bounds.lower.x), toCell(bounds.lower.y), toCell(bounds.upper.x), toCell(bounds.upper.y) };
+		}
+		void link(const std::uint32_t proxy, const CellRange& range)
+		{
+			for (std::int32_t y = range.minY; y <= range.maxY; ++y)
+			{
+				for (std::int32_t x = range.minX; x <= range.maxX; ++x)
+				{
+					cells_[Key(x, y)].emplace_back(proxy);
+				}
+			}
+		}
+		void unlink(const std::uint32_t proxy, const CellRange& range)
+		{
+			for (std::int32_t y = range.minY; y <= range.maxY; ++y)
+			{
+				for (std::int32_t x = range.minX; x <= range.maxX; ++x)
+				{
+					const auto it = cells_.find(Key(x, y));
+					if (it == cells_.end())
+					{
+						continue;
+					}
+					auto& cell = it->second;
+					for (std::size_t i = 0; i < cell.size(); ++i)
+					{
+						if (cell[i] == proxy)
+						{
+							cell[i] = cell.back();
+							cell.pop_back();
+							break;
+						}
+					}
+					if (cell.empty())
+					{
+						cells_.erase(it);
+					}
+				}
+			}
+		}
+		//!プロキシをセルから消して再利用できるようにします。表との結び付きは外してから呼びます
+		void removeProxy(const std::uint32_t proxy)
+		{
+			auto& p = proxies_[proxy];
+			unlink(proxy, p.range);
+			p.entity = nullptr;
+			freeProxies_.emplace_back(proxy);
+		}
+	public:
+		//!セルの一辺の長さを指定します
+		explicit SpatialHashGrid(const float cellSize) :
+			cellSize_(cellSize),
+			invCellSize_(1.f / cellSize)
+		{}
+
+		/**
+		* @brief Entityを指定した矩形で登録します。登録済みであれば矩形を更新します
+		* @details セルの範囲が変わらなければセルへの登録はそのままです
+		*/
+		void set(Entity& entity, const AABB& bounds)
+		{
+			const EntityId id = entity.getId();
+			std::uint32_t proxy = table_.touch(id, [this](const std::uint32_t stale) { removeProxy(stale); });
+			const CellRange range = toRange(bounds);
+			if (proxy == NONE)
+			{
+				if (freeProxies_.empty())
+				{
+					proxy = static_cast<std::uint32_t>(proxies_.size());
+					proxies_.emplace_back();
+				}
+				else
+				{
+					proxy = freeProxies_.back();
+					freeProxies_.pop_back();
+				}
+				auto& p = proxies_[proxy];
+				p.entity = &entity;
+				p.bounds = bounds;
+				p.range = range;
+				table_.insert(id, proxy);
+				link(proxy, range);
+			}
+			else
+			{
+				auto& p = proxies_[proxy];
+				p.bounds = bounds;
+				if (!(p.range == range))
+				{
+					unlink(proxy, p.range);
+					p.range = range;
+					link(proxy, range);
+				}
+			}
+		}
+		//!Entityの登録を外します
+		void remove(const EntityId& id)
+		{
+			const std::uint32_t proxy = table_.erase(id);
+			if (proxy != NONE)
+			{
+				removeProxy(proxy);
+			}
+		}
+		/**
+		* @brief マネージャー内のコライダーを持つEntityをすべて登録し直します
+		* @details コライダーがなくなったEntityや死んだEntityは登録から外れます
+		* - refresh()で破棄されたEntityはここで外れるので、refresh()の後、判定の前に毎フレーム呼びます
+		*/
+		void update(EntityManager& manager)
+		{
+			table_.beginFrame();
+			EachColliderBounds(manager, [this](Entity& e, const AABB& bounds) { set(e, bounds); });
+			table_.sweep([this](const std::uint32_t proxy) { removeProxy(proxy); });
+		}
+		/**
+		* @brief 矩形が重なっているEntityのペアをすべて渡します
+		* @param func void(Entity&, Entity&)の関数
+		* @details セルはキーの順に走査するので、同じ順番で登録すればペアの順番は実行環境によらず同じです。
+		* ContactCacheのイベントの順番もこれで決まります
+		*/
+		template <typename Func> void findPairs(Func&& func)
+		{
+			sortedCells_.clear();
+			sortedCells_.reserve(cells_.size());
+			for (const auto& cell : cells_)
+			{
+				sortedCells_.emplace_back(&cell);
+			}
+			std::sort(sortedCells_.begin(), sortedCells_.end(),
+				[](const Cells::value_type* a, const Cells::value_type* b) { return a->first < b->first; });
+			for (const auto& pCell : sortedCells_)
+			{
+				const auto& cell = *pCell;
+				const auto& ids = cell.second;
+				const auto cellX = static_cast<std::int32_t>(static_cast<std::uint32_t>(cell.first >> 32));
+				const auto cellY = static_cast<std::int32_t>(static_cast<std::uint32_t>(cell.first));
+				for (std::size_t i = 0; i < ids.size(); ++i)
+				{
+					const Proxy& a = proxies_[ids[i]];
+					for (std::size_t j = i + 1; j < ids.size(); ++j)
+					{
+						const Proxy& b = proxies_[ids[j]];
+						//重なりの左上を含むセルでだけ報告する
+						if ((std::max)(a.range.minX, b.range.minX) != cellX ||
+							(std::max)(a.range.minY, b.range.minY) != cellY ||
+							!a.bounds.overlaps(b.bounds))
+						{
+							continue;
+						}
+						func(*a.entity, *b.entity);
+					}
+				}
+			}
+		}
+		/**
+		* @brief 矩形と重なっているEntityをすべて渡します
+		* @param func void(Entity&)の関数
+		*/
+		template <typename Func> void query(const AABB& bounds, Func&& func)
+		{
+			++queryStamp_;
+			const CellRange range = toRange(bounds);
+			for (std::int32_t y = range.minY; y <= range.maxY; ++y)
+			{
+				for (std::int32_t x = range.minX; x <= range.maxX; ++x)
+				{
+					const auto it = cells_.find(Key(x, y));
+					if (it == cells_.end())
+					{
+						continue;
+					}
+					for (const auto& id : it->second)
+					{
+						auto& p = proxies_[id];
+						if (p.queryStamp != queryStamp_ && p.bounds.overlaps(bounds))
+						{
+							p.queryStamp = queryStamp_;
+							func(*p.entity);
+						}
+					}
+				}
+			}
+		}
+		//!点を含むEntityをすべて渡します
+		template <typename Func> void query(const Vec2& point, Func&& func)
+		{
+			query(AABB(point, point), std::forward<Func>(func));
+		}
+		//!登録されているEntityの数を返します
+		[[nodiscard]] std::size_t size() const noexcept { return proxies_.size() - freeProxies_.size(); }
+		//!セルの一辺の長さを返します
+		[[nodiscard]] float getCellSize() const noexcept { return cellSize_; }
+		//!登録をすべて外します
+		void clear()
+		{
+			proxies_.clear();
+			freeProxies_.clear();
+			table_.clear();
+			cells_.clear();
+			sortedCells_.clear();
+		}
+	};
+}
@@ -0,0 +1,366 @@
+﻿/**
+* @file SweepAndPrune.hpp
+* @brief 軸ごとの区間をソートして重なりを求めるブロードフェーズです
+* @author agent
+* @date 2026/10/17
+*/
+#pragma once
+#include "AABB.hpp"
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+namespace ECS
+{
+	/**
+	* @brief SweepAndPruneが報告する矩形が重なったペアです
+	* @details 片方がすでに破棄されている場合があるので、EntityManager::getEntity()で取り出してください
+	*/
+	struct OverlapPair final
+	{
+		EntityId a;
+		EntityId b;
+	};
+
+	/**
+	* @brief コライダーの端点を軸ごとにソートしたまま保ち、重なりの変化を求めるSweep and Pruneです
+	* @details 端点の配列は前のフレームの順番から挿入ソートで並べ直すので、少しずつ動くシーンではコストがほぼ登録数に比例します
+	* - 並べ直しで端点が入れ替わったときだけ、もう一方の軸を調べてペアを追加・削除します
+	* - 新しく登録したEntityはまとめてソートして配列に合流させ、1回の走査で新しいEntityが関わる重なりだけを求めます
+	* - update()の後、getBeganPairs()で重なり始めたペアを、getEndedPairs()で離れたペアを取得します
+	* - 横スクロールのように1つの軸に沿って動くものが多い場合に向いています。大きく飛び移るものが多い場合はSpatialHashGridやAABBTreeを使ってください
+	*/
+	class SweepAndPrune final
+	{
+	private:
+		static constexpr std::uint32_t NONE = static_cast<std::uint32_t>(-1);
+		struct Proxy
+		{
+			Entity* entity = nullptr;
+			//!ペアの報告に使うハンドル
+			EntityId id;
+			AABB bounds;
+			//!走査中に重なっている区間の一覧での位置
+			std::uint32_t active = NONE;
+			//!走査中に重なっている新しいプロキシの区間の一覧での位置
+			std::uint32_t activeNew = NONE;
+			bool isNew = false;
+			bool isRemoved = false;
+		};
+		struct Endpoint
+		{
+			float value;
+			//!プロキシの番号 * 2 + 上端なら1
+			std::uint32_t data;
+			[[nodiscard]] std::uint32_t proxy() const noexcept { return data >> 1; }
+			[[nodiscard]] bool isUpper() const noexcept { return (data & 1u) != 0u; }
+			//!同じ値では下端を先に並べ、接しているだけの区間も重なりとして扱う
+			[[nodiscard]] bool operator<(const Endpoint& other) const noexcept
+			{
+				return value < other.value || (value == other.value && (data & 1u) < (other.data & 1u));
+			}
+		};
+		struct Pair
+		{
+			std::uint32_t proxyA;
+			std::uint32_t proxyB;
+		};
+		std::vector<Proxy> proxies_;
+		std::vector<std::uint32_t> freeProxies_;
+		std::vector<std::uint32_t> newProxies_;
+		std::size_t proxyCount_ = 0;
+		ProxyTable<std::uint32_t> table_;
+		//!x軸とy軸の端点
+		std::vector<Endpoint> endpoints_[2];
+		std::vector<Endpoint> merged_;
+		std::vector<std::uint32_t> activeProxies_;
+		std::vector<std::uint32_t> activeNewProxies_;
+		//!矩形が重なっているペア
+		std::vector<Pair> pairs_;
+		std::unordered_map<std::uint64_t, std::uint32_t> pairIndices_;
+		std::vector<OverlapPair> began_;
+		std::vector<OverlapPair> ended_;
+		bool hasRemoved_ = false;
+
+		[[nodiscard]] static std::uint64_t Key(std::uint32_t a, std::uint32_t b) noexcept
+		{
+			if (a > b)
+			{
+				std::swap(a, b);
+			}
+			return (static_cast<std::uint64_t>(a) << 32) | b;
+		}
+		[[nodiscard]] static float Lower(const AABB& bounds, const int axis) noexcept { return axis == 0 ? bounds.lower.x : bounds.lower.y; }
+		[[nodiscard]] static float Upper(const AABB& bounds, const int axis) noexcept { return axis == 0 ? bounds.upper.x : bounds.upper.y; }
+		[[nodiscard]] bool overlapsOn(const std::uint32_t a, const std::uint32_t b, const int axis) const noexcept
+		{
+			const AABB& boundsA = proxies_[a].bounds;
+			const AABB& boundsB = proxies_[b].bounds;
+			return Lower(boundsA, axis) <= Upper(boundsB, axis) && Lower(boundsB, axis) <= Upper(boundsA, axis);
+		}
+		void addPair(const std::uint32_t a, const std::uint32_t b)
+		{
+			if (pairIndices_.emplace(Key(a, b), static_cast<std::uint32_t>(pairs_.size())).second)
+			{
+				pairs_.emplace_back(Pair{ a, b });
+				began_.emplace_back(OverlapPair{ proxies_[a].id, proxies_[b].id });
+			}
+		}
+		void removePair(const std::uint32_t a, const std::uint32_t b)
+		{
+			const auto it = pairIndices_.find(Key(a, b));
+			if (it == pairIndices_.end())
+			{
+				return;
+			}
+			const std::uint32_t index = it->second;
+			pairIndices_.erase(it);
+			ended_.emplace_back(OverlapPair{ proxies_[a].id, proxies_[b].id });
+			if (index + 1 != pairs_.size())
+			{
+				pairs_[index] = pairs_.back();
+				pairIndices_[Key(pairs_[index].proxyA, pairs_[index].proxyB)] = index;
+			}
+			pairs_.pop_back();
+		}
+		//!プロキシに印を付けます。端点とペアはcollectRemoved()でまとめて片付けます。表との結び付きは外してから呼びます
+		void removeProxy(const std::uint32_t proxy) noexcept
+		{
+			auto& p = proxies_[proxy];
+			p.entity = nullptr;
+			p.isRemoved = true;
+			hasRemoved_ = true;
+			--proxyCount_;
+		}
+		/**
+		* @brief 端点を挿入ソートで並べ直し、入れ替わりからペアを更新します
+		* @details 下端が上端を左に追い越せばその軸で重なり始めるので、もう一方の軸も重なっていれば追加します
+		* - 上端が下端を左に追い越せばその軸で離れるので、ペアがあれば削除します
+		* - もう一方の軸は並べ直す前でも今の矩形で調べるので、両方の軸を並べ直した後の結果は矩形の重なりと一致します
+		*/
+		void sortEndpoints(const int axis)
+		{
+			auto& endpoints = endpoints_[axis];
+			for (std::size_t i = 1; i < endpoints.size(); ++i)
+			{
+				const Endpoint current = endpoints[i];
+				std::size_t j = i;
+				for (; j > 0 && current < endpoints[j - 1]; --j)
+				{
+					const Endpoint& prev = endpoints[j - 1];
+					if (current.isUpper() != prev.isUpper())
+					{
+						if (current.isUpper())
+						{
+							removePair(current.proxy(), prev.proxy());
+						}
+						else if (overlapsOn(current.proxy(), prev.proxy(), axis ^ 1))
+						{
+							addPair(current.proxy(), prev.proxy());
+						}
+					}
+					endpoints[j] = prev;
+				}
+				endpoints[j] = current;
+			}
+		}
+		/**
+		* @brief 新しいプロキシの端点をソートして合流させ、x軸の走査で新しいプロキシが関わるペアを求めます
+		* @details 既存のプロキシの下端は重なっている新しいプロキシとだけ、新しいプロキシの下端は重なっているすべてのプロキシと調べます
+		* - 既存同士のペアは調べないので、コストは端点の数と新しいプロキシに重なる数の和に比例します
+		*/
+		void insertNewProxies()
+		{
+			for (int axis = 0; axis < 2; ++axis)
+			{
+				auto& endpoints = endpoints_[axis];
+				const std::size_t oldSize = endpoints.size();
+				for (const auto& proxy : newProxies_)
+				{
+					const AABB& bounds = proxies_[proxy].bounds;
+					endpoints.emplace_back(Endpoint{ Lower(bounds, axis), proxy << 1 });
+					endpoints.emplace_back(Endpoint{ Upper(bounds, axis), (proxy << 1) | 1u });
+				}
+				std::sort(endpoints.begin() + oldSize, endpoints.end());
+				merged_.resize(endpoints.size());
+				std::merge(endpoints.begin(), endpoints.begin() + oldSize, endpoints.begin() + oldSize, endpoints.end(), merged_.begin());
+				endpoints.swap(merged_);
+			}
+			activeProxies_.clear();
+			activeNewProxies_.clear();
+			for (const auto& it : endpoints_[0])
+			{
+				const std::uint32_t proxy = it.proxy();
+				auto& p = proxies_[proxy];
+				if (it.isUpper())
+				{
+					proxies_[activeProxies_.back()].active = p.active;
+					activeProxies_[p.active] = activeProxies_.back();
+					activeProxies_.pop_back();
+					p.active = NONE;
+					if (p.isNew)
+					{
+						proxies_[activeNewProxies_.back()].activeNew = p.activeNew;
+						activeNewProxies_[p.activeNew] = activeNewProxies_.back();
+						activeNewProxies_.pop_back();
+						p.activeNew = NONE;
+					}
+					continue;
+				}
+				for (const auto& other : p.isNew ? activeProxies_ : activeNewProxies_)
+				{
+					if (overlapsOn(proxy, other, 1))
+					{
+						addPair(proxy, other);
+					}
+				}
+				p.active = static_cast<std::uint32_t>(activeProxies_.size());
+				activeProxies_.emplace_back(proxy);
+				if (p.isNew)
+				{
+					p.activeNew = static_cast<std::uint32_t>(activeNewProxies_.size());
+					activeNewProxies_.emplace_back(proxy);
+				}
+			}
+			for (const auto& proxy : newProxies_)
+			{
+				proxies_[proxy].isNew = false;
+			}
+			newProxies_.clear();
+		}
+		//!外れたプロキシの端点とペアを取り除き、プロキシを再利用できるようにします
+		void collectRemoved()
+		{
+			for (std::size_t i = 0; i < pairs_.size();)
+			{
+				if (proxies_[pairs_[i].proxyA].isRemoved || proxies_[pairs_[i].proxyB].isRemoved)
+				{
+					removePair(pairs_[i].proxyA, pairs_[i].proxyB);
+					continue;
+				}
+				++i;
+			}
+			for (auto& endpoints : endpoints_)
+			{
+				endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(),
+					[this](const Endpoint& e) { return proxies_[e.proxy()].isRemoved; }), endpoints.end());
+			}
+			newProxies_.erase(std::remove_if(newProxies_.begin(), newProxies_.end(),
+				[this](const std::uint32_t proxy) { return proxies_[proxy].isRemoved; }), newProxies_.end());
+			for (std::uint32_t i = 0; i < proxies_.size(); ++i)
+			{
+				if (proxies_[i].isRemoved)
+				{
+					proxies_[i].isRemoved = false;
+					proxies_[i].isNew = false;
+					freeProxies_.emplace_back(i);
+				}
+			}
+			hasRemoved_ = false;
+		}
+	public:
+		SweepAndPrune() = default;
+
+		/**
+		* @brief Entityを指定した矩形で登録します。登録済みであれば矩形を更新します
+		* @details 端点の並べ直しと重なりの判定はupdate()で行います
+		*/
+		void set(Entity& entity, const AABB& bounds)
+		{
+			const EntityId id = entity.getId();
+			std::uint32_t proxy = table_.touch(id, [this](const std::uint32_t stale) { removeProxy(stale); });
+			if (proxy == NONE)
+			{
+				if (freeProxies_.empty())
+				{
+					proxy = static_cast<std::uint32_t>(proxies_.size());
+					proxies_.emplace_back();
+				}
+				else
+				{
+					proxy = freeProxies_.back();
+					freeProxies_.pop_back();
+				}
+				proxies_[proxy].entity = &entity;
+				proxies_[proxy].id = id;
+				proxies_[proxy].isNew = true;
+				table_.insert(id, proxy);
+				newProxies_.emplace_back(proxy);
+				++proxyCount_;
+			}
+			proxies_[proxy].bounds = bounds;
+		}
+		//!Entityの登録を外します。離れたペアは次のupdate()で報告します
+		void remove(const EntityId& id) noexcept
+		{
+			const std::uint32_t proxy = table_.erase(id);
+			if (proxy != NONE)
+			{
+				removeProxy(proxy);
+			}
+		}
+		/**
+		* @brief マネージャー内のコライダーを持つEntityをすべて登録し直し、重なりの変化を求めます
+		* @details コライダーがなくなったEntityや死んだEntityは登録から外れ、重なっていたペアは離れたペアとして報告します
+		* - refresh()で破棄されたEntityはここで外れるので、refresh()の後、判定の前に毎フレーム呼びます
+		*/
+		void update(EntityManager& manager)
+		{
+			began_.clear();
+			ended_.clear();
+			table_.beginFrame();
+			EachColliderBounds(manager, [this](Entity& e, const AABB& bounds) { set(e, bounds); });
+			table_.sweep([this](const std::uint32_t proxy) { removeProxy(proxy); });
+			if (hasRemoved_)
+			{
+				collectRemoved();
+			}
+			for (int axis = 0; axis < 2; ++axis)
+			{
+				for (auto& it : endpoints_[axis])
+				{
+					const AABB& bounds = proxies_[it.proxy()].bounds;
+					it.value = it.isUpper() ? Upper(bounds, axis) : Lower(bounds, axis);
+				}
+				sortEndpoints(axis);
+			}
+			if (!newProxies_.empty())
+			{
+				insertNewProxies();
+			}
+		}
+		//!直前のupdate()で矩形が重なり始めたペアを返します
+		[[nodiscard]] const std::vector<OverlapPair>& getBeganPairs() const noexcept { return began_; }
+		//!直前のupdate()で矩形が離れたペアを返します。登録から外れたEntityとのペアも含みます
+		[[nodiscard]] const std::vector<OverlapPair>& getEndedPairs() const noexcept { return ended_; }
+		/**
+		* @brief 今矩形が重なっているペアをすべて渡します
+		* @param func void(Entity&, Entity&)の関数
+		*/
+		template <typename Func> void findPairs(Func&& func)
+		{
+			for (const auto& it : pairs_)
+			{
+				func(*proxies_[it.proxyA].entity, *proxies_[it.proxyB].entity);
+			}
+		}
+		//!登録されているEntityの数を返します
+		[[nodiscard]] std::size_t size() const noexcept { return proxyCount_; }
+		//!登録をすべて外します。離れたペアは報告しません
+		void clear()
+		{
+			proxies_.clear();
+			freeProxies_.clear();
+			newProxies_.clear();
+			proxyCount_ = 0;
+			table_.clear();
+			endpoints_[0].clear();
+			endpoints_[1].clear();
+			pairs_.clear();
+			pairIndices_.clear();
+			began_.clear();
+			ended_.clear();
+			hasRemoved_ = false;
+		}
+	};
+}
@@ -113,7 +113,8 @@ namespace ECS
 		Gravity* gravity_ = nullptr;
 		Velocity2D* velocity_ = nullptr;
 		Position2D* pos_ = nullptr;
-		std::vector<Entity*> otherEntity_{};
+		std::vector<EntityId> otherEntity_{};
+		std::vector<Entity*> pushOutTargets_{};
 		std::function<bool(const Entity&, const Entity&)> collisionFunc_;
 		void checkMove(Vec2& pos, Vec2& velocity)
 		{
@@ -136,7 +137,7 @@ namespace ECS
 					pos.x += pointEntityMove.x;
 					pointEntityMove.x = 0;
 				}
-				for (const auto& it : otherEntity_)
+				for (const auto& it : pushOutTargets_)
 				{
 					if (collisionFunc_(*owner, *it))
 					{
@@ -164,7 +165,7 @@ namespace ECS
 					pos.y += pointEntityMove.y;
 					pointEntityMove.y = 0;
 				}
-				for (const auto& it : otherEntity_)
+				for (const auto& it : pushOutTargets_)
 				{
 					if (collisionFunc_(*owner, *it))
 					{
@@ -175,6 +176,24 @@ namespace ECS
 				}
 			}
 		}
+		//!押し出し対象のハンドルから、まだ存在するEntityを取り出します
+		void resolveOtherEntity()
+		{
+			pushOutTargets_.clear();
+			const auto& manager = owner->getManager();
+			otherEntity_.erase(std::remove_if(otherEntity_.begin(), otherEntity_.end(),
+				[&](const EntityId& id)
+			{
+				Entity* pEntity = manager.getEntity(id);
+				if (pEntity == nullptr)
+				{
+					return true;
+				}
+				pushOutTargets_.emplace_back(pEntity);
+				return false;
+			}),
+				otherEntity_.end());
+		}
 	public:
 		void initialize() override
 		{
@@ -192,13 +211,25 @@ namespace ECS
 		}
 		void update() override
 		{
+			resolveOtherEntity();
+			const Vec2 prePos = pos_->val;
+			const Vec2 preVelocity = velocity_->val;
 			velocity_->val.y += gravity_->val;
 			checkMove(pos_->val, velocity_->val);
+			if (velocity_->val.x != preVelocity.x || velocity_->val.y != preVelocity.y)
+			{
+				owner->markChanged<Velocity2D>();
+			}
+			if (pos_->val.x != prePos.x || pos_->val.y != prePos.y)
+			{
+				owner->markChanged<Position2D>();
+			}
 		}
 		void setVelocity(const float& x, const float& y)
 		{
 			velocity_->val.x = x;
 			velocity_->val.y = y;
+			owner->markChanged<Velocity2D>();
 		}
 		void setGravity(const float& g = Gravity::DEFAULT)
 		{
@@ -209,10 +240,14 @@ namespace ECS
 		{
 			collisionFunc_ = func;
 		}
-		//!引数に指定したEntityにめり込まないようにする
+		//!引数に指定したEntityにめり込まないようにする。削除されたEntityは自動で対象から外れます
 		void pushOutEntity(std::vector<Entity*>& e)
 		{
-			otherEntity_ = e;
+			otherEntity_.clear();
+			for (const auto& it : e)
+			{
+				otherEntity_.emplace_back(it->getId());
+			}
 		}
 	};
 
@@ -220,21 +255,50 @@ namespace ECS
 	@brief PositionとRotationとScaleの親子を作ります
 	@detail 親子関係を作ると生のPosition等のデータを直接変更できなくなります
 	- このコンポーネントがある場合は、translate系メソッドで動かすことができます
+	- 親子関係はEntityManagerのTransformHierarchyで管理され、EntityManager::update()の最後に親から順に反映されます
+	- 子のワールド座標は親の座標、回転、拡大率を適用した位置になります。回転は親との和、拡大率は親との積です
+	- EntityPoolで眠ると親子関係を解除して階層から外れ、再利用時に親のないノードとして登録し直されます
 	*/
 	class Transform2D final : public ComponentSystem
 	{
 	private:
 		Vec2 initPos_;
 		Vec2 initScale_{ 1.f,1.f };
-		Vec2 localPos_;
-		Vec2 localScale_;
 		float initRota_ = 0;
-		float localRota_ = 0;
 		Position2D* globalPos_ = nullptr;
 		Rotation* globalRota_ = nullptr;
 		Scale2D* globalScale_ = nullptr;
-		Transform2D* parent_ = nullptr;
-		std::vector<Transform2D*> childs_{};
+		TransformHierarchy::Handle handle_ = TransformHierarchy::NONE;
+		std::vector<EntityId> childs_{};
+
+		[[nodiscard]] TransformHierarchy& getHierarchy() const
+		{
+			return owner->getManager().getTransformHierarchy();
+		}
+		//!階層にノードを登録済みか返します。initialize()の前と眠っている間は登録されていません
+		[[nodiscard]] bool hasNode() const noexcept
+		{
+			return handle_ != TransformHierarchy::NONE;
+		}
+		//!親がいるか返します。親が削除されていたら親子関係は解除されています
+		[[nodiscard]] bool hasParent() const
+		{
+			return hasNode() && getHierarchy().getParent(handle_) != TransformHierarchy::NONE;
+		}
+		//!階層にノードを登録します
+		void addNode()
+		{
+			handle_ = getHierarchy().add(TransformHierarchy::Binding
+			{
+				owner,
+				&globalPos_->val,
+				&globalRota_->val,
+				&globalScale_->val,
+				GetComponentTypeID<Position2D>(),
+				GetComponentTypeID<Rotation>(),
+				GetComponentTypeID<Scale2D>()
+			});
+		}
 
 	public:
 		Transform2D() = default;
@@ -251,6 +315,16 @@ namespace ECS
 			initScale_(scale),
 			initRota_(rotation)
 		{}
+		//ハンドルを二重に解放しないようにコピーとムーブを禁止する
+		Transform2D(const Transform2D&) = delete;
+		Transform2D& operator=(const Transform2D&) = delete;
+		~Transform2D()
+		{
+			if (handle_ != TransformHierarchy::NONE)
+			{
+				getHierarchy().remove(handle_);
+			}
+		}
 
 		void initialize() override
 		{
@@ -269,23 +343,28 @@ namespace ECS
 			globalPos_ = &owner->getComponent<Position2D>();
 			globalRota_ = &owner->getComponent<Rotation>();
 			globalScale_ = &owner->getComponent<Scale2D>();
+			if (handle_ != TransformHierarchy::NONE)
+			{
+				return;
+			}
+			addNode();
 		}
-
-		void update() override
+		//!眠っている間に計算されないように階層から外します。子は親のないノードになります
+		void onSleep() override
 		{
-			if (parent_ != nullptr)
+			if (handle_ != TransformHierarchy::NONE)
 			{
-				globalPos_->val = parent_->globalPos_->val.offsetCopy(localPos_);
-				globalRota_->val = parent_->globalRota_->val + localRota_;
-				{
-					const float angle = atan2(
-						parent_->globalPos_->val.y - globalPos_->val.y,
-						parent_->globalPos_->val.x - globalPos_->val.x);
-					const float global_angle = parent_->globalRota_->val + (Math::ToDegree(angle));
-					globalPos_->val.x = parent_->globalPos_->val.x + cosf(Math::ToRadian(global_angle)) * localPos_.x;
-					globalPos_->val.y = parent_->globalPos_->val.y + sinf(Math::ToRadian(global_angle)) * localPos_.y;
-				}
-				globalScale_->val = parent_->globalScale_->val.offsetCopy(localScale_);
+				getHierarchy().remove(handle_);
+				handle_ = TransformHierarchy::NONE;
+			}
+			childs_.clear();
+		}
+		//!再利用されたら親のないノードとして登録し直します
+		void onRecycle() override
+		{
+			if (handle_ == TransformHierarchy::NONE && globalPos_ != nullptr)
+			{
+				addNode();
 			}
 		}
 
@@ -294,22 +373,36 @@ namespace ECS
 		- 親を設定するとこのEntityは生のPosition等のデータを直接変更できなくなります
 		- 親との縁を切る場合はnullptrを指定してください
 		- 設定後はsetLocal系のメソッドやtranslate系のメソッドで動かしてください
+		- 親子関係が循環する場合や、どちらかが階層に登録されていない場合は設定されません
 		*/
 		void setParent(const Entity * const pEntity)
 		{
+			if (!hasNode())
+			{
+				DOUT << "Transform2D is not initialized" << std::endl;
+				return;
+			}
 			if (pEntity == nullptr)
 			{
-				parent_ = nullptr;
+				getHierarchy().setParent(handle_, TransformHierarchy::NONE);
 				return;
 			}
 
 			if (pEntity->hasComponent<Transform2D>())
 			{
-				parent_ = &pEntity->getComponent<Transform2D>();
-				localPos_ = globalPos_->val - parent_->globalPos_->val;
-				localRota_ = globalRota_->val - parent_->globalRota_->val;
-				localScale_ = globalScale_->val - parent_->globalScale_->val;
-				parent_->childs_.emplace_back(this);
+				auto& parent = pEntity->getComponent<Transform2D>();
+				if (!parent.hasNode())
+				{
+					DOUT << "parent Transform2D is not initialized" << std::endl;
+				}
+				else if (getHierarchy().setParent(handle_, parent.handle_))
+				{
+					parent.childs_.emplace_back(owner->getId());
+				}
+				else
+				{
+					DOUT << "parent is a descendant of this entity" << std::endl;
+				}
 			}
 			else
 			{
@@ -326,23 +419,38 @@ namespace ECS
 			assert(child != nullptr);
 			child->getComponent<Transform2D>().setParent(owner);
 		}
-		//!指定した子を取得します
+		//!指定した子を取得します。子が削除されていた場合はnullptrが返ります
 		Transform2D* getChild(const size_t & id)
 		{
-			return childs_.at(id);
+			const Entity* pEntity = owner->getManager().getEntity(childs_.at(id));
+			if (pEntity == nullptr || !pEntity->hasComponent<Transform2D>())
+			{
+				return nullptr;
+			}
+			return &pEntity->getComponent<Transform2D>();
+		}
+		//!最後に計算したワールド行列を返します
+		[[nodiscard]] Matrix2x3 getWorldMatrix() const
+		{
+			if (!hasNode())
+			{
+				return globalPos_ == nullptr ? Matrix2x3{} : Matrix2x3::Make(globalPos_->val, globalRota_->val, globalScale_->val);
+			}
+			return getHierarchy().getWorldMatrix(handle_);
 		}
 		/*Entityをtranslation分移動します
 		@param translation 移動量
 		*/
 		void translatePosition(const Vec2 & translation)
 		{
-			if (parent_)
+			if (hasParent())
 			{
-				localPos_ += translation;
+				getHierarchy().setLocalPosition(handle_, getHierarchy().getLocalPosition(handle_) + translation);
 			}
 			else
 			{
 				globalPos_->val += translation;
+				owner->markChanged<Position2D>();
 			}
 		}
 
@@ -351,13 +459,14 @@ namespace ECS
 		*/
 		void translateRotation(const float& translation)
 		{
-			if (parent_)
+			if (hasParent())
 			{
-				localRota_ += translation;
+				getHierarchy().setLocalRotation(handle_, getHierarchy().getLocalRotation(handle_) + translation);
 			}
 			else
 			{
 				globalRota_->val += translation;
+				owner->markChanged<Rotation>();
 			}
 		}
 
@@ -366,44 +475,56 @@ namespace ECS
 		*/
 		void translateScale(const Vec2 & translation)
 		{
-			if (parent_)
+			if (hasParent())
 			{
-				localScale_ += translation;
+				getHierarchy().setLocalScale(handle_, getHierarchy().getLocalScale(handle_) + translation);
 			}
 			else
 			{
 				globalScale_->val += translation;
+				owner->markChanged<Scale2D>();
 			}
 		}
 
-		//!Entityの相対座標を設定します
+		//!Entityの相対座標を設定します。親がいない場合は無視されます
 		void setLocalPosition(const float& x, const float& y)
 		{
-			localPos_.x = x;
-			localPos_.y = y;
+			if (hasParent())
+			{
+				getHierarchy().setLocalPosition(handle_, Vec2(x, y));
+			}
 		}
-		//!Entityの相対座標を設定します
+		//!Entityの相対座標を設定します。親がいない場合は無視されます
 		void setLocalPosition(const Vec2 & setPos)
 		{
-			localPos_.x = setPos.x;
-			localPos_.y = setPos.y;
+			if (hasParent())
+			{
+				getHierarchy().setLocalPosition(handle_, setPos);
+			}
 		}
-		//!Entityの相対回転率を設定します
+		//!Entityの相対回転率を設定します。親がいない場合は無視されます
 		void setLocalRotation(const float& r)
 		{
-			localRota_ = r;
+			if (hasParent())
+			{
+				getHierarchy().setLocalRotation(handle_, r);
+			}
 		}
-		//!Entityの相対拡大率を設定します
+		//!Entityの相対拡大率を設定します。親がいない場合は無視されます
 		void setLocalScale(const float& scaleX, const float& scaleY)
 		{
-			localScale_.x = scaleX;
-			localScale_.y = scaleY;
+			if (hasParent())
+			{
+				getHierarchy().setLocalScale(handle_, Vec2(scaleX, scaleY));
+			}
 		}
-		//!Entityの相対拡大率を設定します
+		//!Entityの相対拡大率を設定します。親がいない場合は無視されます
 		void setLocalScale(const Vec2 & scale)
 		{
-			localScale_.x = scale.x;
-			localScale_.y = scale.y;
+			if (hasParent())
+			{
+				getHierarchy().setLocalScale(handle_, scale);
+			}
 		}
 	};
 
@@ -413,9 +534,16 @@ namespace ECS
 	class KillEntity final : public ComponentSystem
 	{
 	private:
+		int span_;
 		int cnt_;
 	public:
-		KillEntity(const int span) :cnt_(span) {}
+		KillEntity(const int span) :span_(span), cnt_(span) {}
+
+		//!EntityPoolで再利用されたら、コンストラクタで指定したフレーム数から数え直します
+		void onRecycle() override
+		{
+			cnt_ = span_;
+		}
 
 		void update() override
 		{
@@ -438,6 +566,7 @@ namespace ECS
 	/*!
 	@brief このコンポーネントがついているEntityにイベント(関数)を追加し,マネージャーから呼び出せるようにします
 	* テンプレート引数   1戻り値,2タグとして扱う型(ただの識別子なので重複しなければなんでもよい、Defaultでvoid)
+	* @deprecated Entityごとに毎フレーム関数を呼ぶので数が多いと遅くなります。EntityManager::getEvents<E>()を使ってください
 	*/
 	template<class T, class Tag = void>
 	class EventFunctionSystem final : public ComponentSystem
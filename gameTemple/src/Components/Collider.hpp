@@ -322,8 +322,8 @@ namespace ECS
 	{
 	private:
 		LineData2D* line_ = nullptr;
-		Entity* start_ = nullptr;
-		Entity* end_ = nullptr;
+		EntityId start_;
+		EntityId end_;
 		Vec2 offSetPos1_;
 		Vec2 offSetPos2_;
 		unsigned int color_ = 4294967295;
@@ -342,8 +342,17 @@ namespace ECS
 		{
 			if (isJoint)
 			{
-				line_->p1 = start_->getComponent<Position2D>().val;
-				line_->p2 = end_->getComponent<Position2D>().val;
+				const auto& manager = owner->getManager();
+				const Entity* start = manager.getEntity(start_);
+				const Entity* end = manager.getEntity(end_);
+				if (start == nullptr || end == nullptr)
+				{
+					//結んでいたEntityが削除されたので最後の位置のまま残す
+					isJoint = false;
+					return;
+				}
+				line_->p1 = start->getComponent<Position2D>().val;
+				line_->p2 = end->getComponent<Position2D>().val;
 			}
 		}
 		void draw2D() override
@@ -372,12 +381,12 @@ namespace ECS
 			offSetPos2_.x = x;
 			offSetPos2_.y = y;
 		}
-		//!引数に指定したエンティティ同士を線で結びます
+		//!引数に指定したエンティティ同士を線で結びます。どちらかが削除されると線はその位置で止まります
 		void setJoint(Entity* start, Entity* end)
 		{
 			isJoint = true;
-			start_ = start;
-			end_ = end;
+			start_ = start->getId();
+			end_ = end->getId();
 		}
 		/** @brief 線分の描画を有効にします*/
 		void drawEnable() { isDraw_ = true; }
@@ -0,0 +1,185 @@
+﻿/**
+* @file  BlockPool.hpp
+* @brief EntityやComponentを確保するための固定サイズのブロックプールです
+* @author agent
+* @date 2026/10/17
+*/
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <typeinfo>
+#include <algorithm>
+#include <utility>
+#include <assert.h>
+
+#pragma push_macro("new")
+#undef new
+
+namespace ECS
+{
+	//!プールの使用状況です
+	struct BlockPoolStats final
+	{
+		//!確保している型の名前
+		const char* name;
+		//!ブロック1つのバイト数
+		std::size_t blockSize;
+		//!現在使用中のブロック数
+		std::size_t live;
+		//!使用中のブロック数の最大値
+		std::size_t peak;
+		//!確保済みのブロック数
+		std::size_t capacity;
+	};
+
+	//!型の異なるプールをまとめて扱うための基底クラスです
+	class IBlockPool
+	{
+	public:
+		virtual ~IBlockPool() = default;
+		//!プールの使用状況を返します
+		[[nodiscard]] virtual BlockPoolStats getStats() const = 0;
+	};
+
+	//!生成されたプールを登録しておくクラスです
+	class BlockPoolRegistry final
+	{
+	private:
+		BlockPoolRegistry() = delete;
+	public:
+		[[nodiscard]] static std::vector<const IBlockPool*>& Get()
+		{
+			static std::vector<const IBlockPool*> pools;
+			return pools;
+		}
+		//!登録されているすべてのプールの使用状況を返します
+		[[nodiscard]] static std::vector<BlockPoolStats> GetStats()
+		{
+			std::vector<BlockPoolStats> stats;
+			stats.reserve(Get().size());
+			for (const auto& it : Get())
+			{
+				stats.emplace_back(it->getStats());
+			}
+			return stats;
+		}
+	};
+
+	/**
+	* @brief 型ごとに固定サイズのブロックを使い回すプールです
+	* @details ブロックはスラブ単位でまとめて確保し、解放されたブロックは空きリストに戻して再利用します
+	* - スラブはプールが破棄されるまで解放しないので、一度ピークまで確保すれば以降の生成と破棄でヒープ確保は起きません
+	* - スレッドセーフではありません
+	* - EntityManagerより先に破棄されないよう、EntityManagerを静的な変数にしないでください
+	*/
+	template <typename T>
+	class BlockPool final : public IBlockPool
+	{
+	private:
+		union Block
+		{
+			Block* next;
+			alignas(T) unsigned char storage[sizeof(T)];
+		};
+		static constexpr std::size_t SlabBytes = 16 * 1024;
+		static constexpr std::size_t BlocksPerSlab = sizeof(Block) * 16 < SlabBytes ? SlabBytes / sizeof(Block) : 16;
+		std::vector<std::unique_ptr<Block[]>> slabs_;
+		Block* free_ = nullptr;
+		std::size_t live_ = 0;
+		std::size_t peak_ = 0;
+
+		void grow()
+		{
+			slabs_.emplace_back(std::make_unique<Block[]>(BlocksPerSlab));
+			Block* slab = slabs_.back().get();
+			for (std::size_t i = BlocksPerSlab; i-- > 0;)
+			{
+				slab[i].next = free_;
+				free_ = &slab[i];
+			}
+		}
+		BlockPool()
+		{
+			BlockPoolRegistry::Get().emplace_back(this);
+		}
+	public:
+		BlockPool(const BlockPool&) = delete;
+		BlockPool& operator=(const BlockPool&) = delete;
+		~BlockPool()
+		{
+			assert(live_ == 0 && "BlockPool is destroyed while objects are alive");
+			auto& pools = BlockPoolRegistry::Get();
+			pools.erase(std::remove(pools.begin(), pools.end(), this), pools.end());
+		}
+
+		[[nodiscard]] static BlockPool& Get()
+		{
+			static BlockPool pool;
+			return pool;
+		}
+
+		/**
+		* @brief プールからブロックを取り出してオブジェクトを生成します
+		* @param args コンストラクタの引数
+		* @return T* 生成したオブジェクト
+		* @details コンストラクタが例外を投げた場合、ブロックはプールに戻してから例外をそのまま投げ直します
+		*/
+		template <typename... TArgs>[[nodiscard]] T* create(TArgs&&... args)
+		{
+			if (free_ == nullptr)
+			{
+				grow();
+			}
+			Block* block = free_;
+			free_ = block->next;
+			T* p;
+			try
+			{
+				p = new(block->storage) T(std::forward<TArgs>(args)...);
+			}
+			catch (...)
+			{
+				//コンストラクタが例外を投げたらブロックをプールに戻す
+				block->next = free_;
+				free_ = block;
+				throw;
+			}
+			if (++live_ > peak_)
+			{
+				peak_ = live_;
+			}
+			return p;
+		}
+
+		//!オブジェクトを破棄してブロックをプールに戻します
+		void destroy(T* p) noexcept
+		{
+			if (p == nullptr)
+			{
+				return;
+			}
+			p->~T();
+			Block* block = reinterpret_cast<Block*>(p);
+			block->next = free_;
+			free_ = block;
+			--live_;
+		}
+
+		//!最低でもcount個のブロックが確保済みになるようにします
+		void reserve(const std::size_t count)
+		{
+			while (slabs_.size() * BlocksPerSlab < count)
+			{
+				grow();
+			}
+		}
+
+		[[nodiscard]] BlockPoolStats getStats() const override
+		{
+			return BlockPoolStats{ typeid(T).name(), sizeof(Block), live_, peak_, slabs_.size() * BlocksPerSlab };
+		}
+	};
+}
+
+#pragma pop_macro("new")
@@ -1,10 +1,361 @@
 ﻿#include "ECS.hpp"
+#include <fstream>
+#include <sstream>
 
 void ECS::Entity::addGroup(const Group& group) noexcept
 {
 	nowGroup_ = group;
 	groupBitSet_[group] = true;
 	manager_.addToGroup(this, group);
+	manager_.markQueryDirty(*this);
+}
+
+void ECS::Entity::removeGroup(const Group& group) noexcept
+{
+	groupBitSet_[group] = false;
+	manager_.markGroupDirty(group);
+	manager_.markQueryDirty(*this);
+}
+
+void ECS::Entity::destroy() noexcept
+{
+	if (!isActive_)
+	{
+		return;
+	}
+	isActive_ = false;
+	manager_.markDead(*this);
+}
+
+void ECS::Entity::registerComponent(const ComponentID id, ComponentSystem* pComponent)
+{
+	manager_.getComponentPool(id).add(id_.index, this, pComponent, manager_.getChangeTick());
+	manager_.markComponentAdded(id, *this);
+	manager_.markQueryDirty(*this);
+}
+
+void ECS::Entity::markChanged(const ComponentID id) noexcept
+{
+	manager_.getComponentPool(id).touch(id_.index, manager_.getChangeTick());
+}
+
+void ECS::Entity::unregisterComponent(const ComponentID id) noexcept
+{
+	manager_.getComponentPool(id).remove(id_.index);
+	manager_.markComponentUnregistered(id, *this);
+	manager_.markQueryDirty(*this);
+	if (!hasRemovedComponent_)
+	{
+		hasRemovedComponent_ = true;
+		manager_.markComponentRemoved(*this);
+	}
+}
+
+void ECS::Entity::registerTag(const ComponentID id)
+{
+	manager_.passiveComponents_.set(id);
+	registerComponent(id, nullptr);
+}
+
+void ECS::Entity::unregisterTag(const ComponentID id) noexcept
+{
+	manager_.getComponentPool(id).remove(id_.index);
+	manager_.markComponentUnregistered(id, *this);
+	manager_.markQueryDirty(*this);
+}
+
+void ECS::Entity::attachShared(const ComponentID id, ComponentSystem* pShared)
+{
+	for (auto& c : components_)
+	{
+		if (c != nullptr && c->typeID_ == id && c->isActive())
+		{
+			//共有コンポーネントの要素は値を所有していないので、手放してから差し替える
+			c.release();
+			c.reset(pShared);
+			manager_.getComponentPool(id).replace(id_.index, pShared, manager_.getChangeTick());
+			return;
+		}
+	}
+	components_.emplace_back(ComponentPtr(pShared, ComponentDeleter{ [](ComponentSystem*) {} }));
+	registerComponent(id, pShared);
+}
+
+void ECS::Entity::detachShared(const ComponentID id) noexcept
+{
+	//共有している値のフラグは変えられないので、要素の所有を手放してnullptrにし、refreshComponent()で取り除く
+	for (auto& c : components_)
+	{
+		if (c != nullptr && c->typeID_ == id && c->isActive())
+		{
+			c.release();
+			break;
+		}
+	}
+	unregisterComponent(id);
+}
+
+void ECS::Entity::updateProfiled()
+{
+	for (auto& c : components_)
+	{
+		if (c == nullptr || c->isStop_)
+		{
+			continue;
+		}
+		const std::int64_t begin = EntityManager::ProfileNow();
+		c->update();
+		auto& cost = manager_.costs_[c->typeID_];
+		cost.updateTime.fetch_add(EntityManager::ProfileNow() - begin, std::memory_order_relaxed);
+		cost.updateCalls.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void ECS::Entity::draw3DProfiled()
+{
+	for (auto& c : components_)
+	{
+		if (c == nullptr)
+		{
+			continue;
+		}
+		const std::int64_t begin = EntityManager::ProfileNow();
+		c->draw3D();
+		auto& cost = manager_.costs_[c->typeID_];
+		cost.draw3DTime.fetch_add(EntityManager::ProfileNow() - begin, std::memory_order_relaxed);
+		cost.draw3DCalls.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void ECS::Entity::draw2DProfiled()
+{
+	for (auto& c : components_)
+	{
+		if (c == nullptr)
+		{
+			continue;
+		}
+		const std::int64_t begin = EntityManager::ProfileNow();
+		c->draw2D();
+		auto& cost = manager_.costs_[c->typeID_];
+		cost.draw2DTime.fetch_add(EntityManager::ProfileNow() - begin, std::memory_order_relaxed);
+		cost.draw2DCalls.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+std::vector<ECS::ComponentStats> ECS::EntityManager::getComponentStats() const
+{
+	//共有コンポーネントは作った値の数で数える
+	std::array<std::size_t, MaxComponents> sharedCount{};
+	for (const auto& it : sharedComponents_)
+	{
+		++sharedCount[it->typeID_];
+	}
+	const auto& infos = GetComponentTypeInfos();
+	std::vector<ComponentStats> stats;
+	for (std::size_t id = 0; id < MaxComponents && infos[id].name != nullptr; ++id)
+	{
+		const auto& pool = componentPools_[id];
+		const auto& cost = costs_[id];
+		if (pool.size() == 0 && cost.updateCalls == 0 && cost.draw2DCalls == 0 && cost.draw3DCalls == 0)
+		{
+			continue;
+		}
+		const std::size_t instances = passiveComponents_[id] ? sharedCount[id] : pool.size();
+		stats.emplace_back(ComponentStats{
+			infos[id].name, id, pool.size(), instances * infos[id].size, pool.getMemoryUsage(),
+			static_cast<double>(cost.updateTime) / 1000000.0, cost.updateCalls,
+			static_cast<double>(cost.draw2DTime) / 1000000.0, cost.draw2DCalls,
+			static_cast<double>(cost.draw3DTime) / 1000000.0, cost.draw3DCalls });
+	}
+	return stats;
+}
+
+std::string ECS::EntityManager::getComponentStatsJson() const
+{
+	std::ostringstream ss;
+	ss << "{\n\t\"components\": [";
+	bool isFirst = true;
+	for (const auto& it : getComponentStats())
+	{
+		ss << (isFirst ? "\n" : ",\n") << "\t\t{ \"name\": \"";
+		isFirst = false;
+		for (const char* p = it.name; *p != '\0'; ++p)
+		{
+			if (*p == '"' || *p == '\\')
+			{
+				ss << '\\';
+			}
+			ss << *p;
+		}
+		ss << "\", \"id\": " << it.id <<
+			", \"count\": " << it.count <<
+			", \"bytes\": " << it.bytes <<
+			", \"poolBytes\": " << it.poolBytes <<
+			", \"updateMs\": " << it.updateMs <<
+			", \"updateCalls\": " << it.updateCalls <<
+			", \"draw2DMs\": " << it.draw2DMs <<
+			", \"draw2DCalls\": " << it.draw2DCalls <<
+			", \"draw3DMs\": " << it.draw3DMs <<
+			", \"draw3DCalls\": " << it.draw3DCalls << " }";
+	}
+	ss << "\n\t]\n}\n";
+	return ss.str();
+}
+
+bool ECS::EntityManager::dumpComponentStats(const std::string& path) const
+{
+	std::ofstream ofs(path, std::ios::out | std::ios::trunc);
+	if (!ofs)
+	{
+		return false;
+	}
+	ofs << getComponentStatsJson();
+	return static_cast<bool>(ofs);
+}
+
+void ECS::EntityManager::dispatchObservers()
+{
+	std::vector<Entity*> entities;
+	std::size_t notifiedDead = 0;
+	bool isDispatched = true;
+	//通知の中での登録と解除は、呼び出し中の関数の配列を壊さないよう最後にまとめて行う
+	isDispatchingObservers_ = true;
+	//通知の中で追加や削除が起きた場合に備えて、新しい記録がなくなるまで繰り返す
+	while (isDispatched)
+	{
+		isDispatched = false;
+		for (std::size_t id = 0; id < MaxComponents; ++id)
+		{
+			if (observers_[id] == nullptr)
+			{
+				continue;
+			}
+			if (!observers_[id]->added.empty())
+			{
+				entities.swap(observers_[id]->added);
+				for (const auto& func : observers_[id]->onAdd)
+				{
+					if (clearedObservers_[id])
+					{
+						break;
+					}
+					func(entities);
+				}
+				entities.clear();
+				isDispatched = true;
+			}
+			if (observers_[id] != nullptr && !observers_[id]->removed.empty())
+			{
+				entities.swap(observers_[id]->removed);
+				for (const auto& func : observers_[id]->onRemove)
+				{
+					if (clearedObservers_[id])
+					{
+						break;
+					}
+					func(entities);
+				}
+				entities.clear();
+				isDispatched = true;
+			}
+		}
+		if (destroyObserved_.none() || notifiedDead == deadEntities_.size())
+		{
+			continue;
+		}
+		const std::size_t end = deadEntities_.size();
+		destroyObserved_.each([&](const std::size_t id)
+		{
+			for (std::size_t i = notifiedDead; i < end; ++i)
+			{
+				if (deadEntities_[i]->componentBitSet_[id])
+				{
+					entities.emplace_back(deadEntities_[i]);
+				}
+			}
+			if (!entities.empty())
+			{
+				for (const auto& func : observers_[id]->onDestroy)
+				{
+					if (clearedObservers_[id])
+					{
+						break;
+					}
+					func(entities);
+				}
+				entities.clear();
+			}
+		});
+		notifiedDead = end;
+		isDispatched = true;
+	}
+	isDispatchingObservers_ = false;
+	clearedObservers_.reset();
+	//通知の中で行われた登録と解除を順番どおりに反映する
+	std::vector<PendingObserver> pending;
+	pending.swap(pendingObservers_);
+	for (auto& it : pending)
+	{
+		if (it.list == nullptr)
+		{
+			removeObserver(it.id);
+		}
+		else
+		{
+			addObserver(it.id, it.list, std::move(it.func));
+		}
+	}
+}
+
+void ECS::CommandBuffer::playback(EntityManager& manager)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (commands_.empty())
+		{
+			return;
+		}
+		executing_.swap(commands_);
+	}
+	//同じEntityへの処理は記録順を保ったまままとめる
+	std::stable_sort(executing_.begin(), executing_.end(),
+		[](const Command& a, const Command& b)
+	{
+		if (a.kind != b.kind)
+		{
+			return a.kind < b.kind;
+		}
+		return a.id.index < b.id.index;
+	});
+	for (auto& command : executing_)
+	{
+		switch (command.kind)
+		{
+		case Kind::CREATE:
+		{
+			auto& entity = command.hasGroup ? manager.addEntity(command.group) : manager.addEntity();
+			if (command.func)
+			{
+				command.func(entity);
+			}
+			break;
+		}
+		case Kind::MODIFY:
+			if (Entity* pEntity = manager.getEntity(command.id))
+			{
+				command.func(*pEntity);
+			}
+			break;
+		case Kind::DESTROY:
+			if (Entity* pEntity = manager.getEntity(command.id))
+			{
+				pEntity->destroy();
+			}
+			break;
+		}
+	}
+	executing_.clear();
 }
 
 void ECS::EntitiesUpdate(const std::vector<Entity*>& entities)
@@ -30,3 +381,144 @@ void ECS::EntitiesDraw3D(const std::vector<Entity*>& entities)
 		it->draw3D();
 	}
 }
+
+void ECS::TransformHierarchy::rebuild()
+{
+	const std::uint32_t num = static_cast<std::uint32_t>(handles_.size());
+	//子の一覧を作り、親のないノードから深さ優先でたどる
+	std::vector<std::uint32_t> firstChild(num, NO_INDEX);
+	std::vector<std::uint32_t> nextSibling(num, NO_INDEX);
+	for (std::uint32_t i = num; i-- > 0;)
+	{
+		if (!(flags_[i] & DEAD) && parents_[i] != NO_INDEX)
+		{
+			nextSibling[i] = firstChild[parents_[i]];
+			firstChild[parents_[i]] = i;
+		}
+	}
+	std::vector<std::uint32_t> order;
+	order.reserve(num - deadCount_);
+	std::vector<std::uint32_t> stack;
+	for (std::uint32_t i = 0; i < num; ++i)
+	{
+		if ((flags_[i] & DEAD) || parents_[i] != NO_INDEX)
+		{
+			continue;
+		}
+		stack.emplace_back(i);
+		while (!stack.empty())
+		{
+			const std::uint32_t node = stack.back();
+			stack.pop_back();
+			order.emplace_back(node);
+			for (std::uint32_t c = firstChild[node]; c != NO_INDEX; c = nextSibling[c])
+			{
+				stack.emplace_back(c);
+			}
+		}
+	}
+	std::vector<std::uint32_t> newIndex(num, NO_INDEX);
+	for (std::uint32_t i = 0; i < order.size(); ++i)
+	{
+		newIndex[order[i]] = i;
+	}
+	auto permute = [&order](auto& v)
+	{
+		std::remove_reference_t<decltype(v)> sorted;
+		sorted.reserve(order.size());
+		for (const auto& i : order)
+		{
+			sorted.emplace_back(v[i]);
+		}
+		v.swap(sorted);
+	};
+	permute(handles_);
+	permute(parents_);
+	permute(childCounts_);
+	permute(flags_);
+	permute(locals_);
+	permute(localMatrices_);
+	permute(worlds_);
+	permute(worldRotations_);
+	permute(worldScales_);
+	permute(bindings_);
+	for (std::uint32_t i = 0; i < handles_.size(); ++i)
+	{
+		if (parents_[i] != NO_INDEX)
+		{
+			parents_[i] = newIndex[parents_[i]];
+		}
+		indexOf_[handles_[i]] = i;
+	}
+	deadCount_ = 0;
+	isOrderDirty_ = false;
+}
+
+void ECS::TransformHierarchy::update()
+{
+	if (isOrderDirty_)
+	{
+		rebuild();
+	}
+	if (linkCount_ == 0)
+	{
+		return;
+	}
+	for (std::size_t i = 0; i < handles_.size(); ++i)
+	{
+		auto& flag = flags_[i];
+		flag &= ~WORLD_UPDATED;
+		if (flag & DEAD)
+		{
+			continue;
+		}
+		const auto& bind = bindings_[i];
+		auto& local = locals_[i];
+		const std::uint32_t parent = parents_[i];
+		if (parent == NO_INDEX)
+		{
+			if (childCounts_[i] == 0)
+			{
+				continue;
+			}
+			//親のないノードはコンポーネントが直接動かされるので、値の変化を調べる
+			if (local.position != *bind.position || local.rotation != *bind.rotation || local.scale != *bind.scale)
+			{
+				local.position = *bind.position;
+				local.rotation = *bind.rotation;
+				local.scale = *bind.scale;
+				flag |= LOCAL_DIRTY;
+			}
+			if (!(flag & LOCAL_DIRTY))
+			{
+				continue;
+			}
+			localMatrices_[i] = Matrix2x3::Make(local.position, local.rotation, local.scale);
+			worlds_[i] = localMatrices_[i];
+			worldRotations_[i] = local.rotation;
+			worldScales_[i] = local.scale;
+		}
+		else
+		{
+			if (!(flag & LOCAL_DIRTY) && !(flags_[parent] & WORLD_UPDATED))
+			{
+				continue;
+			}
+			if (flag & LOCAL_DIRTY)
+			{
+				localMatrices_[i] = Matrix2x3::Make(local.position, local.rotation, local.scale);
+			}
+			worlds_[i] = worlds_[parent] * localMatrices_[i];
+			worldRotations_[i] = worldRotations_[parent] + local.rotation;
+			worldScales_[i] = Vec2(worldScales_[parent].x * local.scale.x, worldScales_[parent].y * local.scale.y);
+			bind.position->x = worlds_[i].tx;
+			bind.position->y = worlds_[i].ty;
+			*bind.rotation = worldRotations_[i];
+			*bind.scale = worldScales_[i];
+			bind.entity->markChanged(bind.positionID);
+			bind.entity->markChanged(bind.rotationID);
+			bind.entity->markChanged(bind.scaleID);
+		}
+		flag = static_cast<std::uint8_t>((flag & ~LOCAL_DIRTY) | WORLD_UPDATED);
+	}
+}
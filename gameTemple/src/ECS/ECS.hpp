@@ -8,16 +8,55 @@
 -# すべてのエンティティを削除するremoveAll()追加
 - 2018/10/16 tonarinohito
 -# コンポーネントをEntity::stopComponent<>()で停止できるようにした
+- 2026/10/17 agent
+-# 同じシグネチャのコンポーネントをチャンクに詰めて保持するChunkStorage追加
+-# コンポーネントの型ごとのスパースセットとEntityManager::view<>()追加
+-# 世代付きのハンドルEntityIdを追加し、死んだEntityのスロットを再利用するようにした
+-# EntityとComponentを型ごとのBlockPoolから確保するようにした
+-# 更新中の構造変更をrefresh()までため込むCommandBuffer追加
+-# refresh()の後始末を死んだEntityと変更のあったグループだけに限定した
+-# コンポーネントを型ごとにまとめて更新するEntityManager::updateByType()追加
+-# コンポーネントの追加と変更を記録するティックと、View::each()のAdded/Changedフィルタ追加
+-# コンポーネントとグループの上限を256に拡張し、シグネチャの判定をSIMD化したSignatureに置き換えた
+-# 型名から求める安定した型ハッシュGetComponentTypeHash()追加
+-# Transform2Dの親子関係を親から順に並べて管理するTransformHierarchy追加
+-# コンポーネントの構成を1度だけ組み立てるPrefabと、まとめて生成するEntityManager::instantiate()追加
+-# 死んだEntityをコンポーネントごと保持して再利用するEntityPool追加
+-# 型ごとのイベントをフレーム単位で受け渡すEvents<E>とEntityManager::getEvents<E>()追加
+-# コンポーネントの追加、削除、Entityの削除をrefresh()でまとめて通知するオブザーバー追加
+-# 実体を持たないタグと、複数のEntityで1つの値を参照する共有コンポーネントShared<T>追加
+-# グループと必須、除外コンポーネントで絞り込んだ結果を差分で保持するQuery追加
+-# EntityManagerの状態をバイナリで保存、復元するSnapshot追加
+-# 指定したコンポーネントの値を過去数フレーム分保持し、補間と巻き戻しに使うComponentHistory追加
+-# コンポーネントの型ごとの数、メモリ使用量、更新と描画の時間を計測するプロファイル機能追加
+-# Entityが登録されているグループをまとめて返すEntity::getGroups()追加
 * @note  参考元 https://github.com/SuperV1234/Tutorials
 */
 #pragma once
-#include <bitset>
 #include <array>
 #include <memory>
 #include <vector>
 #include <assert.h>
 #include <iostream>
 #include <algorithm>
+#include <unordered_map>
+#include <tuple>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <typeinfo>
+#include "BlockPool.hpp"
+#include "Signature.hpp"
+#include "TransformHierarchy.hpp"
+#include "Events.hpp"
+
+#pragma push_macro("new")
+#undef new
 
 /**
 * @brief EntityComponentSystemに関連した機能群
@@ -27,34 +66,130 @@ namespace ECS
 	class Entity;
 	class ComponentSystem;
 	class EntityManager;
+	class EntityPool;
+	class Snapshot;
+	class ChunkStorage;
+	class ChunkArchetype;
 
 	using ComponentID = std::size_t;
 	using Group = std::size_t;
+	//!コンポーネントの追加や変更の時刻を表すティック
+	using ChangeTick = std::uint32_t;
+
+	//!最大コンポーネント数。必要に応じて限界値は変える
+	constexpr std::size_t MaxComponents = 256;
+	//!最大グループ数。必要に応じて限界値は変える
+	constexpr std::size_t MaxGroups = 256;
 
-	//!AddされたらコンポーネントのIDをインクリメントする関数
+	/**
+	* @brief AddされたらコンポーネントのIDをインクリメントする関数
+	* @details 型が初めて使われるのがワーカースレッドの場合もあるので、カウンターはatomicにしています
+	*/
 	[[nodiscard]] inline ComponentID GetNewComponentTypeID() noexcept
 	{
-		static ComponentID lastID = 0;
-		return ++lastID;
+		static std::atomic<ComponentID> lastID{ 0 };
+		const ComponentID id = lastID++;
+		assert(id < MaxComponents && "too many component types. increase MaxComponents");
+		return id;
+	}
+	//!コンポーネントの型の情報です
+	struct ComponentTypeInfo final
+	{
+		//!型の名前
+		const char* name = nullptr;
+		//!1つあたりのバイト数。タグは0です
+		std::size_t size = 0;
+	};
+	//!IDごとのコンポーネントの型の情報を返します。IDが振られていない要素のnameはnullptrです
+	[[nodiscard]] inline std::array<ComponentTypeInfo, MaxComponents>& GetComponentTypeInfos() noexcept
+	{
+		static std::array<ComponentTypeInfo, MaxComponents> infos;
+		return infos;
+	}
+	//!Tに新しいIDを振り、型の情報を登録します
+	template <typename T>[[nodiscard]] inline ComponentID RegisterComponentType() noexcept
+	{
+		const ComponentID id = GetNewComponentTypeID();
+		GetComponentTypeInfos()[id] = ComponentTypeInfo{ typeid(T).name(), std::is_empty_v<T> ? 0 : sizeof(T) };
+		return id;
 	}
-	//!複数のコンポーネントをIDによって管理するための関数
+	/**
+	* @brief 複数のコンポーネントをIDによって管理するための関数
+	* @details IDは配列の添え字に使うため0から詰めて振られ、初めて使われた順に決まります
+	* - 実行をまたいで同じ値が必要な場合はGetComponentTypeHash()を使ってください
+	*/
 	template <typename T>[[nodiscard]] inline ComponentID GetComponentTypeID() noexcept
 	{
-		static ComponentID typeID = GetNewComponentTypeID();
+		static ComponentID typeID = RegisterComponentType<T>();
+		return typeID;
+	}
+	//!イベントの型ごとにIDを振る関数
+	[[nodiscard]] inline std::size_t GetNewEventTypeID() noexcept
+	{
+		static std::atomic<std::size_t> lastID{ 0 };
+		return lastID++;
+	}
+	//!イベントの型のIDを返します
+	template <typename E>[[nodiscard]] inline std::size_t GetEventTypeID() noexcept
+	{
+		static const std::size_t typeID = GetNewEventTypeID();
 		return typeID;
 	}
 
-	//!最大コンポーネント数。必要に応じて限界値は変える
-	constexpr std::size_t MaxComponents = 32;
-	//!最大グループ数。必要に応じて限界値は変える
-	constexpr std::size_t MaxGroups = 32;
+	/**
+	* @brief 型名から求めたハッシュ値を返します
+	* @details コンパイル時に決まり、同じコンパイラであれば実行やビルドをまたいでも変わりません
+	* - 保存データなどで型を識別する場合に使います
+	*/
+	template <typename T>[[nodiscard]] constexpr std::uint64_t GetComponentTypeHash() noexcept
+	{
+#if defined(_MSC_VER)
+		constexpr const char* name = __FUNCSIG__;
+#else
+		constexpr const char* name = __PRETTY_FUNCTION__;
+#endif
+		std::uint64_t hash = 14695981039346656037ull;
+		for (const char* p = name; *p != '\0'; ++p)
+		{
+			hash = (hash ^ static_cast<unsigned char>(*p)) * 1099511628211ull;
+		}
+		return hash;
+	}
+	//型名の取り方がコンパイラごとに違うので、定数式で求まることと型ごとに値が変わることをここで確かめる
+	static_assert(GetComponentTypeHash<Entity>() != GetComponentTypeHash<ComponentSystem>(), "GetComponentTypeHash must distinguish types");
+	static_assert(GetComponentTypeHash<std::uint32_t>() != GetComponentTypeHash<std::int32_t>(), "GetComponentTypeHash must distinguish types");
 
 	//!コンポーネントのフラグ管理用
-	using ComponentBitSet = std::bitset<MaxComponents>;
-	//!フラグとIDを関連付けるために静的配列で用意
-	using ComponentArray = std::array<ComponentSystem*, MaxComponents>;
-	//!Groupも同様にIDを関連付けるために静的配列で用意
-	using GroupBitSet = std::bitset<MaxGroups>;
+	using ComponentBitSet = Signature<MaxComponents>;
+	//!Groupのフラグ管理用
+	using GroupBitSet = Signature<MaxGroups>;
+
+	/**
+	* @brief Entityを識別するハンドルです
+	* @details スロット番号と世代の組です。スロットが再利用されると世代が変わるので、
+	* 死んだEntityのハンドルは無効になります。フレームをまたいでEntityを参照したい場合はこちらを保持してください
+	* - 世代0は無効なハンドルを表します
+	*/
+	struct EntityId final
+	{
+		std::uint32_t index = 0u;
+		std::uint32_t generation = 0u;
+		//!無効なハンドルか返します。Entityがまだ存在するかはEntityManager::isValid()で判定してください
+		[[nodiscard]] constexpr bool isNull() const noexcept { return generation == 0u; }
+		//!64bitの値にまとめて返します
+		[[nodiscard]] constexpr std::uint64_t value() const noexcept
+		{
+			return (static_cast<std::uint64_t>(generation) << 32) | index;
+		}
+		[[nodiscard]] constexpr bool operator==(const EntityId& id) const noexcept
+		{
+			return index == id.index && generation == id.generation;
+		}
+		[[nodiscard]] constexpr bool operator!=(const EntityId& id) const noexcept
+		{
+			return !(*this == id);
+		}
+	};
 
 	/**
 	* @brief Componentの基底クラスです
@@ -65,8 +200,10 @@ namespace ECS
 	private:
 		//Entityによって殺されたいのでこうなった
 		friend class Entity;
+		friend class EntityManager;
 		bool active_ = true;
 		bool isStop_ = false;
+		std::size_t typeID_ = 0;
 		void removeThis() { active_ = false; }
 	public:
 		Entity* owner = nullptr;
@@ -74,6 +211,10 @@ namespace ECS
 		virtual void update() {};
 		virtual void draw3D() {};
 		virtual void draw2D() {};
+		//!EntityPoolで再利用されるときに呼ばれます。initialize()は呼ばれないので、状態を初期値に戻す場合に実装します
+		virtual void onRecycle() {};
+		//!EntityPoolで眠るときに呼ばれます。マネージャー以外に登録した情報を外す場合に実装します
+		virtual void onSleep() {};
 		virtual ~ComponentSystem() {}
 		//!このコンポーネントが生きているか返します
 		[[nodiscard]] virtual bool isActive() const final { return active_; }
@@ -81,6 +222,24 @@ namespace ECS
 		[[nodiscard]] virtual bool isStop() const final { return isStop_; }
 	};
 
+	//!BlockPoolから確保したComponentをプールに戻すためのデリータです
+	struct ComponentDeleter final
+	{
+		void(*release)(ComponentSystem*) = nullptr;
+		void operator()(ComponentSystem* p) const noexcept
+		{
+			release(p);
+		}
+	};
+	using ComponentPtr = std::unique_ptr<ComponentSystem, ComponentDeleter>;
+
+	//!BlockPoolから確保したEntityをプールに戻すためのデリータです
+	struct EntityDeleter final
+	{
+		void operator()(Entity* p) const noexcept;
+	};
+	using EntityPtr = std::unique_ptr<Entity, EntityDeleter>;
+
 	/**
 	* @brief ComponentDataの基底クラスです
 	* @details データにはメソッドを持たせません。
@@ -93,6 +252,148 @@ namespace ECS
 		[[deprecated("can not use")]] void draw2D() override final {}
 	};
 
+	/**
+	* @brief 複数のEntityで1つの値を参照する共有コンポーネントです
+	* @details EntityManager::makeShared<T>()で作り、Entity::setShared()で設定します
+	* - 画像の定義やマテリアルのように、多くのEntityで同じになる大きな値に使います。Entityごとの複製は作られません
+	* - 値はconstな参照でしか取り出せないので変更できません。違う値にする場合は別の値を作って設定し直します
+	* - 作った値はEntityManagerが破棄されるまで残ります。ownerは常にnullptrです
+	*/
+	template <typename T>
+	class Shared final : public ComponentData
+	{
+	private:
+		T value_;
+	public:
+		template <typename... TArgs> explicit Shared(TArgs&&... args) :
+			value_(std::forward<TArgs>(args)...)
+		{}
+		Shared(const Shared&) = delete;
+		Shared& operator=(const Shared&) = delete;
+		//!共有している値を返します
+		[[nodiscard]] const T& get() const noexcept { return value_; }
+		[[nodiscard]] const T& operator*() const noexcept { return value_; }
+		[[nodiscard]] const T* operator->() const noexcept { return &value_; }
+	};
+
+	//!Tが共有コンポーネントか判定します
+	template <typename T> struct IsShared : std::false_type {};
+	template <typename T> struct IsShared<Shared<T>> : std::true_type {};
+	//!Tがタグ(ComponentSystemを継承しない空の型)か判定します
+	template <typename T> constexpr bool IsTag = std::is_empty_v<T> && !std::is_base_of_v<ComponentSystem, T>;
+
+	/**
+	* @brief コンポーネントの型ごとに、そのコンポーネントを持つEntityを管理するスパースセットです
+	* @details Entityの番号から密な配列の位置を引く疎な配列と、Entityとコンポーネントを詰めて並べた密な配列を持ちます
+	* - 追加、削除、存在判定はすべてO(1)です
+	* - 削除は末尾の要素で穴を埋めるので順番は保証されません
+	*/
+	class ComponentPool final
+	{
+	private:
+		static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+		std::vector<std::size_t> sparse_;
+		std::vector<Entity*> entities_;
+		std::vector<ComponentSystem*> components_;
+		std::vector<ChangeTick> addedTicks_;
+		std::vector<ChangeTick> changedTicks_;
+	public:
+		//!指定した番号のEntityが登録されているか返します
+		[[nodiscard]] bool contains(const std::size_t index) const noexcept
+		{
+			return index < sparse_.size() && sparse_[index] != NONE;
+		}
+		//!Entityとコンポーネントを登録します。追加と変更のティックはtickになります
+		void add(const std::size_t index, Entity* pEntity, ComponentSystem* pComponent, const ChangeTick tick)
+		{
+			if (index >= sparse_.size())
+			{
+				sparse_.resize(index + 1, NONE);
+			}
+			sparse_[index] = entities_.size();
+			entities_.emplace_back(pEntity);
+			components_.emplace_back(pComponent);
+			addedTicks_.emplace_back(tick);
+			changedTicks_.emplace_back(tick);
+		}
+		//!密な配列をcount個分確保します
+		void reserve(const std::size_t count)
+		{
+			entities_.reserve(count);
+			components_.reserve(count);
+			addedTicks_.reserve(count);
+			changedTicks_.reserve(count);
+		}
+		//!指定した番号のEntityを削除します
+		void remove(const std::size_t index) noexcept
+		{
+			if (!contains(index))
+			{
+				return;
+			}
+			const std::size_t dense = sparse_[index];
+			const std::size_t last = entities_.size() - 1;
+			if (dense != last)
+			{
+				entities_[dense] = entities_[last];
+				components_[dense] = components_[last];
+				addedTicks_[dense] = addedTicks_[last];
+				changedTicks_[dense] = changedTicks_[last];
+				sparse_[indexOf(dense)] = dense;
+			}
+			entities_.pop_back();
+			components_.pop_back();
+			addedTicks_.pop_back();
+			changedTicks_.pop_back();
+			sparse_[index] = NONE;
+		}
+		//!指定した番号のEntityのコンポーネントを返します
+		[[nodiscard]] ComponentSystem* get(const std::size_t index) const noexcept
+		{
+			return components_[sparse_[index]];
+		}
+		//!指定した番号のEntityのコンポーネントを差し替え、変更されたことを記録します
+		void replace(const std::size_t index, ComponentSystem* pComponent, const ChangeTick tick) noexcept
+		{
+			components_[sparse_[index]] = pComponent;
+			changedTicks_[sparse_[index]] = tick;
+		}
+		//!指定した番号のEntityのコンポーネントが変更されたことを記録します
+		void touch(const std::size_t index, const ChangeTick tick) noexcept
+		{
+			if (contains(index))
+			{
+				changedTicks_[sparse_[index]] = tick;
+			}
+		}
+		//!指定した番号のEntityのコンポーネントが追加されたティックを返します
+		[[nodiscard]] ChangeTick getAddedTick(const std::size_t index) const noexcept
+		{
+			return addedTicks_[sparse_[index]];
+		}
+		//!指定した番号のEntityのコンポーネントが最後に変更されたティックを返します。追加も変更に含まれます
+		[[nodiscard]] ChangeTick getChangedTick(const std::size_t index) const noexcept
+		{
+			return changedTicks_[sparse_[index]];
+		}
+		//!密な配列のdense番目のEntityの番号を返します
+		[[nodiscard]] std::size_t indexOf(const std::size_t dense) const noexcept;
+		//!登録されているEntityの数を返します
+		[[nodiscard]] std::size_t size() const noexcept { return entities_.size(); }
+		//!登録されているEntityを密に並べた配列を返します
+		[[nodiscard]] const std::vector<Entity*>& getEntities() const noexcept { return entities_; }
+		//!スパースセット自体が確保しているバイト数を返します。コンポーネントの実体は含みません
+		[[nodiscard]] std::size_t getMemoryUsage() const noexcept
+		{
+			return sparse_.capacity() * sizeof(std::size_t) +
+				entities_.capacity() * sizeof(Entity*) +
+				components_.capacity() * sizeof(ComponentSystem*) +
+				(addedTicks_.capacity() + changedTicks_.capacity()) * sizeof(ChangeTick);
+		}
+		//!登録されているコンポーネントを密に並べた配列を返します。タグの場合はすべてnullptrです
+		[[nodiscard]] const std::vector<ComponentSystem*>& getComponents() const noexcept { return components_; }
+	};
+
 	/**
 	* @brief 1つ以上のコンポーネントによって定義されるEntityです
 	* @details データや振る舞い、グループを設定し使用してください
@@ -101,23 +402,66 @@ namespace ECS
 	{
 	private:
 		friend class EntityManager;
+		friend class EntityPool;
+		friend class ChunkStorage;
+		//!ChunkStorageに持っているコンポーネントの位置です
+		struct ChunkLocation
+		{
+			ChunkArchetype* archetype = nullptr;
+			std::size_t chunk = 0;
+			std::size_t row = 0;
+		};
+		friend class Snapshot;
 		EntityManager& manager_;
+		EntityPool* pool_ = nullptr;
+		EntityId id_;
+		std::size_t position_ = 0u;
 		Group nowGroup_ = 0u;
 		bool isActive_ = true;
-		std::vector<std::unique_ptr<ComponentSystem>> components_;
-		ComponentArray  componentArray_{};
+		bool hasRemovedComponent_ = false;
+		bool isQueryDirty_ = false;
+		std::vector<ComponentPtr> components_;
 		ComponentBitSet componentBitSet_;
 		GroupBitSet groupBitSet_;
+		ChunkLocation chunkLocation_;
 		//!非アクティブなコンポーネントを消す
 		void refreshComponent()
 		{
+			if (!hasRemovedComponent_)
+			{
+				return;
+			}
+			hasRemovedComponent_ = false;
 			components_.erase(std::remove_if(std::begin(components_), std::end(components_),
-				[](const std::unique_ptr<ComponentSystem> &pCom)
+				[](const ComponentPtr &pCom)
 			{
-				return !pCom->isActive();
+				//外した共有コンポーネントの要素はnullptrになっている
+				return pCom == nullptr || !pCom->isActive();
 			}),
 				std::end(components_));
 		}
+		//!マネージャーがプロファイル中か返します
+		[[nodiscard]] bool isProfiling() const noexcept;
+		//!時間を計測しながらコンポーネントの更新処理を行います
+		void updateProfiled();
+		//!時間を計測しながらコンポーネントの3D描画処理を行います
+		void draw3DProfiled();
+		//!時間を計測しながらコンポーネントの2D描画処理を行います
+		void draw2DProfiled();
+		//!マネージャーのスパースセットからコンポーネントを引きます
+		[[nodiscard]] ComponentSystem* findComponent(const ComponentID id) const noexcept;
+		//!マネージャーのスパースセットにコンポーネントを登録します
+		void registerComponent(const ComponentID id, ComponentSystem* pComponent);
+		//!マネージャーのスパースセットからコンポーネントを外し、次のrefresh()で破棄されるようにします
+		void unregisterComponent(const ComponentID id) noexcept;
+		//!タグをマネージャーのスパースセットに登録します
+		void registerTag(const ComponentID id);
+		//!タグをマネージャーのスパースセットから外します
+		void unregisterTag(const ComponentID id) noexcept;
+		//!共有コンポーネントを設定、または差し替えます
+		void attachShared(const ComponentID id, ComponentSystem* pShared);
+		//!共有コンポーネントを外します。参照は次のrefresh()で取り除かれます
+		void detachShared(const ComponentID id) noexcept;
 
 	public:
 		//!コンストラクタでマネージャーを指定してください
@@ -125,13 +469,18 @@ namespace ECS
 		//!このEntityについているComponentの初期化処理を行います
 		void initialize()
 		{
-			for (auto& c : components_) c->initialize();
+			for (auto& c : components_) if (c != nullptr) c->initialize();
 		}
 
 		//!このEntityについているComponentの更新処理を行います
 		void update()
 		{
 			refreshComponent();
+			if (isProfiling())
+			{
+				updateProfiled();
+				return;
+			}
 			for (auto& c : components_)
 			{
 				if (c == nullptr || c->isStop_)
@@ -145,6 +494,11 @@ namespace ECS
 		//!このEntityについているComponentの3D描画処理を行います
 		void draw3D()
 		{
+			if (isProfiling())
+			{
+				draw3DProfiled();
+				return;
+			}
 			for (auto& c : components_)
 			{
 				if (c == nullptr)
@@ -158,6 +512,11 @@ namespace ECS
 		//!このEntityについているComponentの2D描画処理を行います
 		void draw2D()
 		{
+			if (isProfiling())
+			{
+				draw2DProfiled();
+				return;
+			}
 			for (auto& c : components_)
 			{
 				if (c == nullptr)
@@ -171,8 +530,17 @@ namespace ECS
 		//!Entityの生存状態を返します
 		[[nodiscard]] bool isActive() const { return isActive_; }
 
+		//!マネージャー内でのEntityの番号を返します。番号は死んだEntityのものが再利用されます
+		[[nodiscard]] std::size_t getIndex() const noexcept { return id_.index; }
+
+		//!Entityのハンドルを返します
+		[[nodiscard]] EntityId getId() const noexcept { return id_; }
+
+		//!このEntityを管理しているマネージャーを返します
+		[[nodiscard]] EntityManager& getManager() const noexcept { return manager_; }
+
 		//!Entityを殺します
-		void destroy() { isActive_ = false; }
+		void destroy() noexcept;
 
 		//!Entityが指定したグループに登録されているか返します
 		[[nodiscard]] bool hasGroup(const Group& group) const noexcept
@@ -180,14 +548,14 @@ namespace ECS
 			return groupBitSet_[group];
 		}
 
+		//!Entityが登録されているグループをまとめて返します
+		[[nodiscard]] const GroupBitSet& getGroups() const noexcept { return groupBitSet_; }
+
 		//!Entityをグループに登録します
 		void addGroup(const Group& group) noexcept;
 
 		//!Entityをグループから消します
-		void removeGroup(const Group& group) noexcept
-		{
-			groupBitSet_[group] = false;
-		}
+		void removeGroup(const Group& group) noexcept;
 		//!グループを登録し直します
 		void changeGroup(const Group& setGroup) noexcept
 		{
@@ -210,6 +578,8 @@ namespace ECS
 		*/
 		template <typename T, typename... TArgs> T& addComponent(TArgs&&... args)
 		{
+			static_assert(!IsTag<T>, "use addTag() for tags");
+			static_assert(!IsShared<T>::value, "use setShared() for shared components");
 			//重複は許可しない
 			if (hasComponent<T>())
 			{
@@ -218,14 +588,15 @@ namespace ECS
 			}
 			//Tips: std::forward
 			//関数テンプレートの引数を転送する。
-			T* c(new T(std::forward<TArgs>(args)...));
+			T* c(BlockPool<T>::Get().create(std::forward<TArgs>(args)...));
 			c->owner = this;
-			std::unique_ptr<ComponentSystem> uPtr(c);
+			c->typeID_ = GetComponentTypeID<T>();
+			ComponentPtr uPtr(c, ComponentDeleter{ [](ComponentSystem* p) { BlockPool<T>::Get().destroy(static_cast<T*>(p)); } });
 			components_.emplace_back(std::move(uPtr));
 
 			//識別するためのIDと生存フラグをセット
-			componentArray_[GetComponentTypeID<T>()] = c;
 			componentBitSet_[GetComponentTypeID<T>()] = true;
+			registerComponent(GetComponentTypeID<T>(), c);
 
 			c->initialize();
 			return *c;
@@ -234,12 +605,82 @@ namespace ECS
 		//!指定したコンポーネントを削除します
 		template<typename T> void removeComponent() noexcept
 		{
+			static_assert(!IsTag<T> && !IsShared<T>::value, "use removeTag() or removeShared()");
 			if (hasComponent<T>())
 			{
 				getComponent<T>().removeThis();
 				componentBitSet_[GetComponentTypeID<T>()] = false;
+				unregisterComponent(GetComponentTypeID<T>());
+			}
+		}
+		/**
+		* @brief データを持たないタグを追加します
+		* @details Tは空の構造体にします。コンポーネントの実体は作られず、シグネチャのビットとスパースセットへの登録だけを持ちます
+		* - hasComponent<T>()やview<T>()で通常のコンポーネントと同じように扱えます
+		*/
+		template <typename T> void addTag()
+		{
+			static_assert(IsTag<T>, "tag must be an empty type that does not derive from ComponentSystem");
+			if (!hasComponent<T>())
+			{
+				componentBitSet_[GetComponentTypeID<T>()] = true;
+				registerTag(GetComponentTypeID<T>());
+			}
+		}
+		//!指定したタグを外します
+		template <typename T> void removeTag() noexcept
+		{
+			static_assert(IsTag<T>, "tag must be an empty type that does not derive from ComponentSystem");
+			if (hasComponent<T>())
+			{
+				componentBitSet_[GetComponentTypeID<T>()] = false;
+				unregisterTag(GetComponentTypeID<T>());
+			}
+		}
+		/**
+		* @brief 共有コンポーネントを設定します
+		* @param shared EntityManager::makeShared<T>()で作った値
+		* @details 値は複製されず、同じ値を設定したEntityはすべて1つの実体を参照します
+		* - すでに設定されている場合は値を差し替え、変更として記録します
+		*/
+		template <typename T> void setShared(Shared<T>& shared)
+		{
+			componentBitSet_[GetComponentTypeID<Shared<T>>()] = true;
+			attachShared(GetComponentTypeID<Shared<T>>(), &shared);
+		}
+		//!共有コンポーネントの値を返します
+		template <typename T>[[nodiscard]] const T& getShared() const
+		{
+			return getComponent<Shared<T>>().get();
+		}
+		//!共有コンポーネントが設定されているか返します
+		template <typename T>[[nodiscard]] bool hasShared() const
+		{
+			return hasComponent<Shared<T>>();
+		}
+		//!共有コンポーネントを外します。値は他のEntityから参照されている可能性があるので破棄されません
+		template <typename T> void removeShared() noexcept
+		{
+			if (hasComponent<Shared<T>>())
+			{
+				componentBitSet_[GetComponentTypeID<Shared<T>>()] = false;
+				detachShared(GetComponentTypeID<Shared<T>>());
+			}
+		}
+		/**
+		* @brief 指定したコンポーネントを変更したことを記録します
+		* @details ComponentDataは直接書き換えるので、書き換えた側で呼んでください
+		* - View::each()のChangedフィルタで変更を拾えるようになります
+		*/
+		template<typename T> void markChanged() noexcept
+		{
+			if (hasComponent<T>())
+			{
+				markChanged(GetComponentTypeID<T>());
 			}
 		}
+		//!IDで指定したコンポーネントを変更したことを記録します
+		void markChanged(const ComponentID id) noexcept;
 		//!指定したコンポーネントの更新処理を止めます
 		template<typename T> void disable() noexcept
 		{
@@ -258,156 +699,2067 @@ namespace ECS
 		*/
 		template<typename T>[[nodiscard]] T& getComponent() const
 		{
+			static_assert(!IsTag<T>, "tags have no instance");
 			if (!hasComponent<T>())
 			{
 				std::cout << typeid(T).name() << std::endl;
 				assert(hasComponent<T>());
 			}
-			auto ptr(componentArray_[GetComponentTypeID<T>()]);
-			return *static_cast<T*>(ptr);
+			return *static_cast<T*>(findComponent(GetComponentTypeID<T>()));
 		}
 	};
 
+	inline void EntityDeleter::operator()(Entity* p) const noexcept
+	{
+		BlockPool<Entity>::Get().destroy(p);
+	}
+
+	inline std::size_t ComponentPool::indexOf(const std::size_t dense) const noexcept
+	{
+		return entities_[dense]->getIndex();
+	}
+
 	/**
-	* @brief Entity統括クラスです
-	* @details Entityの生成と管理を行います。グループへの登録もこのクラスが行います
+	* @brief Tが指定したティックより後に追加されたEntityだけを走査するフィルタです
+	* @details sinceにはEntityManager::updateChangeTick()の戻り値を渡します
 	*/
-	class EntityManager final
+	template <typename T>
+	struct Added final
 	{
-	private:
-		std::vector<std::unique_ptr<Entity>> entityes_;
-		std::array<std::vector<Entity*>, MaxGroups> groupedEntities_;
-	public:
-		EntityManager()
-		{
-			
-		}
-		//!登録されているEntityの初期化を行います
-		void initialize()
+		ChangeTick since = 0u;
+	};
+
+	/**
+	* @brief Tが指定したティックより後に追加、または変更されたEntityだけを走査するフィルタです
+	* @details 変更はEntity::markChanged<T>()で記録されます
+	*/
+	template <typename T>
+	struct Changed final
+	{
+		ChangeTick since = 0u;
+	};
+
+	//!ビューの関数に渡す引数を返します。タグには実体がないので共通の空のオブジェクトを渡します
+	template <typename T>[[nodiscard]] inline T& GetViewArg(ComponentSystem* pComponent) noexcept
+	{
+		if constexpr (IsTag<T>)
 		{
-			for (auto& e : entityes_) e->initialize();
+			static T tag;
+			return tag;
 		}
-		//!登録されているEntityの更新を行います
-		void update()
+		else
 		{
-			for (auto& e : entityes_)
-			{
-				if (e == nullptr)
-				{
-					continue;
-				}
-				e->update();
-			}
+			return *static_cast<T*>(pComponent);
 		}
+	}
 
-		//!登録されているEntityの3D描画を行います
-		void draw3D()
-		{
-			for (auto& e : entityes_) e->draw3D();
-		}
+	//!型リストの中でTが何番目にあるか返します
+	template <typename T, typename... Ts>[[nodiscard]] constexpr std::size_t TypeIndexOf() noexcept
+	{
+		std::size_t index = 0;
+		((std::is_same_v<T, Ts> ? true : (++index, false)) || ...);
+		return index;
+	}
 
-		/**
-		* @brief グループごとの描画を登録順に行います
-		* @param MaxGroup 最大グループ数
-		*/
-		void orderByDraw(const Group& MaxGroup)
+	/**
+	* @brief 指定したコンポーネントをすべて持つEntityを走査するためのビューです
+	* @details EntityManager::view<>()から取得します
+	* - 登録数が最も少ないスパースセットを基準に走査するので、コストは一致するEntityの数にほぼ比例します
+	* - 走査は末尾から行うので、走査中のEntityのコンポーネントを削除しても安全です
+	*/
+	template <typename... Ts>
+	class View final
+	{
+	private:
+		std::array<const ComponentPool*, sizeof...(Ts)> pools_;
+		const ComponentPool* smallest_ = nullptr;
+
+		[[nodiscard]] bool containsAll(const std::size_t index) const noexcept
 		{
-			for (auto i(0u); i < MaxGroup; ++i)
+			for (const auto& pool : pools_)
 			{
-				const auto& entity = groupedEntities_[i];
-				for (const auto& e : entity)
+				if (!pool->contains(index))
 				{
-					e->draw2D();
+					return false;
 				}
 			}
+			return true;
 		}
-		//!登録されているEntityの2D描画を行います
-		void draw2D()
-		{
-			for (auto& e : entityes_)
-			{
-				e->draw2D();
-			}
-		}
-		//!すべてのエンティティを削除します
-		void removeAll()
+		template <typename Func, typename Pred, std::size_t... I>
+		void eachImpl(Func& func, Pred&& pred, const std::size_t begin, const std::size_t end, std::index_sequence<I...>) const
 		{
-			for (auto& e : entityes_)
+			for (std::size_t i = end; i-- > begin;)
 			{
-				e->destroy();
+				if (i >= smallest_->size())
+				{
+					continue;
+				}
+				Entity* pEntity = smallest_->getEntities()[i];
+				const std::size_t index = smallest_->indexOf(i);
+				if (!containsAll(index) || !pred(index))
+				{
+					continue;
+				}
+				func(*pEntity, GetViewArg<Ts>(pools_[I]->get(index))...);
 			}
 		}
-		//!アクティブでないEntityを削除します。必ず更新処理で呼んでください
-		void refresh()
+	public:
+		explicit View(const std::array<const ComponentPool*, sizeof...(Ts)>& pools) :
+			pools_(pools)
 		{
-			for (auto i(0u); i < MaxGroups; ++i)
+			smallest_ = pools_[0];
+			for (const auto& pool : pools_)
 			{
-				auto& v(groupedEntities_[i]);
-
-				v.erase(std::remove_if(std::begin(v), std::end(v),
-					[i](Entity* pEntity)
+				if (pool->size() < smallest_->size())
 				{
-					return !pEntity->isActive() ||
-						!pEntity->hasGroup(i);
-				}),
-					std::end(v));
+					smallest_ = pool;
+				}
 			}
-
-			entityes_.erase(std::remove_if(std::begin(entityes_), std::end(entityes_),
-				[](const std::unique_ptr<Entity> &pEntity)
-			{
-				return !pEntity->isActive();
-			}),
-				std::end(entityes_));
 		}
-
-		//!指定したグループに登録されているEntity達を返します
-		[[nodiscard]] std::vector<Entity*>& getEntitiesByGroup(const Group& group)
+		/**
+		* @brief 一致するEntityを走査します
+		* @param func void(Entity&, Ts&...)の関数
+		*/
+		template <typename Func> void each(Func&& func) const
 		{
-			return groupedEntities_[group];
+			eachImpl(func, [](std::size_t) { return true; }, 0, smallest_->size(), std::index_sequence_for<Ts...>{});
 		}
-
-		//!Entityを指定したグループに登録します
-		void addToGroup(Entity* pEntity, const Group& group)
+		/**
+		* @brief 一致するEntityのうち、Tが追加されたものだけを走査します
+		* @param func void(Entity&, Ts&...)の関数
+		* @details TはTsのどれかである必要があります
+		*/
+		template <typename T, typename Func> void each(const Added<T>& filter, Func&& func) const
 		{
-			groupedEntities_[group].emplace_back(pEntity);
+			static_assert(std::disjunction_v<std::is_same<T, Ts>...>, "filter type must be in the view");
+			const ComponentPool* pool = pools_[TypeIndexOf<T, Ts...>()];
+			eachImpl(func, [&](const std::size_t index) { return pool->getAddedTick(index) > filter.since; },
+				0, smallest_->size(), std::index_sequence_for<Ts...>{});
 		}
-
 		/**
-		* @brief Entityを生成しそのポインタを返します。
-		* @return Entity& Entityへの参照
-		* @details 作られたEntityはマネージャーが保持します
+		* @brief 一致するEntityのうち、Tが追加または変更されたものだけを走査します
+		* @param func void(Entity&, Ts&...)の関数
+		* @details TはTsのどれかである必要があります。変更が少なければ、ほとんどのEntityはティックの比較だけで読み飛ばされます
 		*/
-		[[nodiscard]] Entity& addEntity()
+		template <typename T, typename Func> void each(const Changed<T>& filter, Func&& func) const
 		{
-			Entity* e = new Entity(*this);
-			std::unique_ptr<Entity> uPtr(e);
-			entityes_.emplace_back(std::move(uPtr));
-			return *e;
+			static_assert(std::disjunction_v<std::is_same<T, Ts>...>, "filter type must be in the view");
+			const ComponentPool* pool = pools_[TypeIndexOf<T, Ts...>()];
+			eachImpl(func, [&](const std::size_t index) { return pool->getChangedTick(index) > filter.since; },
+				0, smallest_->size(), std::index_sequence_for<Ts...>{});
 		}
 		/**
-		* @brief Entityを生成しそのポインタを返します。
-		* @param group 属するグループ(size_t)
-		* @return Entity& Entityへの参照
-		* @details 基本的にこちらを使います。作られたEntityはマネージャーが保持します
+		* @brief 基準のスパースセットの[begin, end)の範囲だけ走査します
+		* @param func void(Entity&, Ts&...)の関数
+		* @details 範囲を分けて並列に処理する場合に使います。範囲の上限はsizeHint()です
 		*/
-		[[nodiscard]] Entity& addEntity(const Group& group)
+		template <typename Func> void eachRange(const std::size_t begin, const std::size_t end, Func&& func) const
 		{
-			Entity* e = new Entity(*this);
-			std::unique_ptr<Entity> uPtr(e);
-			entityes_.emplace_back(std::move(uPtr));
-			entityes_.back()->addGroup(group);
-			return *e;
+			eachImpl(func, [](std::size_t) { return true; }, begin, (std::min)(end, smallest_->size()), std::index_sequence_for<Ts...>{});
 		}
+		//!走査の基準になるスパースセットの要素数を返します。一致するEntityの数の上限です
+		[[nodiscard]] std::size_t sizeHint() const noexcept { return smallest_->size(); }
 	};
 
-	//以下の処理は必要ないかもしれない//
+	/**
+	* @brief Queryの条件です
+	* @details QueryDesc().inGroup(ENEMY).with<Position2D, Hp>().without<Frozen>()のように組み立てます
+	* - グループを指定しない場合はすべてのEntityが対象です。複数指定した場合はどれかに属していれば一致します
+	*/
+	class QueryDesc final
+	{
+	private:
+		friend class Query;
+		GroupBitSet groups_;
+		ComponentBitSet required_;
+		ComponentBitSet excluded_;
+	public:
+		//!対象にするグループを追加します
+		QueryDesc& inGroup(const Group& group) noexcept
+		{
+			groups_.set(group);
+			return *this;
+		}
+		//!必ず持っているコンポーネントやタグを追加します
+		template <typename... Ts> QueryDesc& with() noexcept
+		{
+			(required_.set(GetComponentTypeID<Ts>()), ...);
+			return *this;
+		}
+		//!持っていてはいけないコンポーネントやタグを追加します
+		template <typename... Ts> QueryDesc& without() noexcept
+		{
+			(excluded_.set(GetComponentTypeID<Ts>()), ...);
+			return *this;
+		}
+	};
 
-	//!vectorに格納されているエンティティの更新を行います
+	/**
+	* @brief 条件に一致するEntityの集合を保持し続けるクエリです
+	* @details EntityManager::createQuery()で作ります。マネージャーが保持します
+	* - 結果はrefresh()で、グループやコンポーネントが変わったEntityだけを判定し直して更新します
+	* - 走査のコストは一致するEntityの数だけです。毎フレームhasComponent()で絞り込む必要はありません
+	* - 結果はrefresh()の間でしか変わらないので、走査中にEntityを変更しても安全です
+	*/
+	class Query final
+	{
+	private:
+		friend class EntityManager;
+		static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+		QueryDesc desc_;
+		std::vector<std::size_t> sparse_;
+		std::vector<Entity*> entities_;
+
+		[[nodiscard]] bool matches(const ComponentBitSet& components, const GroupBitSet& groups) const noexcept
+		{
+			return (desc_.groups_.none() || groups.intersects(desc_.groups_)) &&
+				components.containsAll(desc_.required_) &&
+				!components.intersects(desc_.excluded_);
+		}
+		[[nodiscard]] bool contains(const std::size_t index) const noexcept
+		{
+			return index < sparse_.size() && sparse_[index] != NONE;
+		}
+		//!Entityが条件に一致するかで結果に加えるか外します
+		void update(Entity* pEntity, const bool isMatch)
+		{
+			const std::size_t index = pEntity->getIndex();
+			if (isMatch == contains(index))
+			{
+				return;
+			}
+			if (isMatch)
+			{
+				if (index >= sparse_.size())
+				{
+					sparse_.resize(index + 1, NONE);
+				}
+				sparse_[index] = entities_.size();
+				entities_.emplace_back(pEntity);
+				return;
+			}
+			const std::size_t dense = sparse_[index];
+			entities_[dense] = entities_.back();
+			sparse_[entities_[dense]->getIndex()] = dense;
+			entities_.pop_back();
+			sparse_[index] = NONE;
+		}
+	public:
+		explicit Query(const QueryDesc& desc) :
+			desc_(desc)
+		{}
+		Query(const Query&) = delete;
+		Query& operator=(const Query&) = delete;
+		/**
+		* @brief 一致するEntityを走査します
+		* @param func void(Entity&)の関数
+		*/
+		template <typename Func> void each(Func&& func) const
+		{
+			for (std::size_t i = entities_.size(); i-- > 0;)
+			{
+				func(*entities_[i]);
+			}
+		}
+		//!一致するEntityを返します。順番は保証されません
+		[[nodiscard]] const std::vector<Entity*>& getEntities() const noexcept { return entities_; }
+		//!一致するEntityの数を返します
+		[[nodiscard]] std::size_t size() const noexcept { return entities_.size(); }
+		//!一致するEntityがいないか返します
+		[[nodiscard]] bool empty() const noexcept { return entities_.empty(); }
+	};
+
+	//!コンポーネントの型ごとの統計です
+	struct ComponentStats final
+	{
+		//!型の名前
+		const char* name;
+		ComponentID id;
+		//!コンポーネントを持っているEntityの数
+		std::size_t count;
+		//!コンポーネントの実体のバイト数。共有コンポーネントは作った値の分だけです
+		std::size_t bytes;
+		//!スパースセットが確保しているバイト数
+		std::size_t poolBytes;
+		//!前回のresetProfile()からの更新処理の合計時間(ミリ秒)と呼び出し回数
+		double updateMs;
+		std::size_t updateCalls;
+		//!前回のresetProfile()からの2D描画処理の合計時間(ミリ秒)と呼び出し回数
+		double draw2DMs;
+		std::size_t draw2DCalls;
+		//!前回のresetProfile()からの3D描画処理の合計時間(ミリ秒)と呼び出し回数
+		double draw3DMs;
+		std::size_t draw3DCalls;
+	};
+
+	//!ComponentHistoryを型を消して扱うためのインターフェースです
+	class IComponentHistory
+	{
+	public:
+		virtual ~IComponentHistory() = default;
+		//!スパースセットに登録されている値を新しいフレームとして記録します
+		virtual void commit(const ComponentPool& pool) = 0;
+		//!framesAgoフレーム前の値をコンポーネントに書き戻し、それより新しいフレームを捨てます
+		virtual void restore(ComponentPool& pool, const std::size_t framesAgo, const ChangeTick tick) = 0;
+		//!記録しているフレームの数を返します
+		[[nodiscard]] virtual std::size_t size() const noexcept = 0;
+		//!記録をすべて捨てます
+		virtual void clear() noexcept = 0;
+	};
+
+	/**
+	* @brief コンポーネントTのメンバの値を過去数フレーム分、リングバッファに保持します
+	* @details EntityManager::enableHistory()で作り、EntityManager::commitHistory()でフレームを記録します
+	* - フレームごとにEntityの番号を添え字にした値の配列を持つので、記録と参照はどちらもEntityの数に比例するコストで済みます
+	* - 固定フレームレートで更新し、描画ではinterpolate()で直前の2フレームを補間する使い方を想定しています
+	* - EntityManager::rollback()で過去のフレームに巻き戻せます。Entityの生成と削除は巻き戻されません
+	*/
+	template <typename T, typename F>
+	class ComponentHistory final : public IComponentHistory
+	{
+	private:
+		struct Frame
+		{
+			//!記録したEntityの世代。0はそのフレームで値を持っていなかったことを表す
+			std::vector<std::uint32_t> generations;
+			std::vector<F> values;
+		};
+		F T::* field_;
+		std::vector<Frame> frames_;
+		std::size_t head_ = 0;
+		std::size_t size_ = 0;
+
+		[[nodiscard]] const Frame& at(const std::size_t framesAgo) const noexcept
+		{
+			return frames_[(head_ + frames_.size() - framesAgo) % frames_.size()];
+		}
+	public:
+		ComponentHistory(F T::* field, const std::size_t frameCount) :
+			field_(field),
+			frames_(std::max<std::size_t>(frameCount, 1))
+		{}
+		void commit(const ComponentPool& pool) override
+		{
+			if (size_ > 0)
+			{
+				head_ = (head_ + 1) % frames_.size();
+			}
+			size_ = (std::min)(size_ + 1, frames_.size());
+			auto& frame = frames_[head_];
+			std::fill(frame.generations.begin(), frame.generations.end(), 0u);
+			const auto& entities = pool.getEntities();
+			const auto& components = pool.getComponents();
+			for (std::size_t i = 0; i < entities.size(); ++i)
+			{
+				const EntityId id = entities[i]->getId();
+				if (id.index >= frame.generations.size())
+				{
+					frame.generations.resize(id.index + 1, 0u);
+					frame.values.resize(id.index + 1);
+				}
+				frame.generations[id.index] = id.generation;
+				frame.values[id.index] = static_cast<const T*>(components[i])->*field_;
+			}
+		}
+		void restore(ComponentPool& pool, const std::size_t framesAgo, const ChangeTick tick) override
+		{
+			if (framesAgo >= size_)
+			{
+				return;
+			}
+			const Frame& frame = at(framesAgo);
+			const auto& entities = pool.getEntities();
+			const auto& components = pool.getComponents();
+			for (std::size_t i = 0; i < entities.size(); ++i)
+			{
+				const EntityId id = entities[i]->getId();
+				if (id.index < frame.generations.size() && frame.generations[id.index] == id.generation)
+				{
+					static_cast<T*>(components[i])->*field_ = frame.values[id.index];
+					pool.touch(id.index, tick);
+				}
+			}
+			head_ = (head_ + frames_.size() - framesAgo) % frames_.size();
+			size_ -= framesAgo;
+		}
+		[[nodiscard]] std::size_t size() const noexcept override { return size_; }
+		void clear() noexcept override
+		{
+			head_ = 0;
+			size_ = 0;
+		}
+		//!保持できるフレームの数を返します
+		[[nodiscard]] std::size_t capacity() const noexcept { return frames_.size(); }
+		/**
+		* @brief 指定したEntityのframesAgoフレーム前の値を返します
+		* @details 0は最後にcommitHistory()したときの値です。記録がなければnullptrを返します
+		*/
+		[[nodiscard]] const F* get(const Entity& entity, const std::size_t framesAgo = 0) const noexcept
+		{
+			if (framesAgo >= size_)
+			{
+				return nullptr;
+			}
+			const Frame& frame = at(framesAgo);
+			const EntityId id = entity.getId();
+			if (id.index < frame.generations.size() && frame.generations[id.index] == id.generation)
+			{
+				return &frame.values[id.index];
+			}
+			return nullptr;
+		}
+		/**
+		* @brief 直前の2フレームの値を補間して返します
+		* @param alpha 0で1フレーム前、1で最後に記録したフレームの値になります
+		* @details 記録が足りない場合は記録されている値か、コンポーネントの今の値を返します
+		*/
+		[[nodiscard]] F interpolate(const Entity& entity, const float alpha) const
+		{
+			const F* current = get(entity, 0);
+			const F* previous = get(entity, 1);
+			if (current == nullptr)
+			{
+				return entity.getComponent<T>().*field_;
+			}
+			if (previous == nullptr)
+			{
+				return *current;
+			}
+			return *previous + (*current - *previous) * alpha;
+		}
+	};
+
+	//!チャンク1つあたりのバイト数
+	constexpr std::size_t ChunkByteSize = 16 * 1024;
+
+	/**
+	* @brief チャンクに格納するコンポーネントの型情報です
+	* @details 型を消した状態でムーブとデストラクタ、配列ごとの更新と描画を呼ぶために使います
+	*/
+	struct ChunkTypeInfo final
+	{
+		//!チャンク内で連続したcount個の要素をまとめて処理する関数です
+		using ColumnFunc = void(*)(void* first, std::size_t count);
+		ComponentID id;
+		std::size_t size;
+		std::size_t align;
+		void(*move)(void* dst, void* src);
+		void(*destroy)(void* p);
+		//!ComponentSystemを継承していない型はnullptrです
+		ColumnFunc update;
+		ColumnFunc draw2D;
+		ColumnFunc draw3D;
+	};
+
+	/**
+	* @brief 指定した型のChunkTypeInfoを返します
+	* @details ComponentSystemを継承した型は、配列の要素を型を指定して呼ぶので仮想関数の呼び出しになりません
+	*/
+	template <typename T>[[nodiscard]] inline const ChunkTypeInfo& GetChunkTypeInfo() noexcept
+	{
+		static const ChunkTypeInfo info = []
+		{
+			ChunkTypeInfo i =
+			{
+				GetComponentTypeID<T>(),
+				sizeof(T),
+				alignof(T),
+				[](void* dst, void* src) { new(dst) T(std::move(*static_cast<T*>(src))); },
+				[](void* p) { static_cast<T*>(p)->~T(); },
+				nullptr,
+				nullptr,
+				nullptr
+			};
+			if constexpr (std::is_base_of_v<ComponentSystem, T>)
+			{
+				i.update = [](void* first, const std::size_t count)
+				{
+					T* p = static_cast<T*>(first);
+					for (std::size_t n = 0; n < count; ++n)
+					{
+						if (!p[n].isStop())
+						{
+							p[n].T::update();
+						}
+					}
+				};
+				i.draw2D = [](void* first, const std::size_t count)
+				{
+					T* p = static_cast<T*>(first);
+					for (std::size_t n = 0; n < count; ++n)
+					{
+						p[n].T::draw2D();
+					}
+				};
+				i.draw3D = [](void* first, const std::size_t count)
+				{
+					T* p = static_cast<T*>(first);
+					for (std::size_t n = 0; n < count; ++n)
+					{
+						p[n].T::draw3D();
+					}
+				};
+			}
+			return i;
+		}();
+		return info;
+	}
+
+	/**
+	* @brief 同じコンポーネントの組み合わせを持つEntityをまとめたものです
+	* @details 固定サイズのチャンクを持ち、チャンク内はEntityの配列とコンポーネントの型ごとの配列で構成されます
+	* - 要素の削除は末尾の要素を穴に詰めるので、チャンク内は常に隙間なく並びます
+	*/
+	class ChunkArchetype final
+	{
+	private:
+		friend class ChunkStorage;
+		static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+		//!アラインメントを指定して確保したバッファを解放します
+		struct AlignedDeleter
+		{
+			std::size_t align;
+			void operator()(unsigned char* p) const noexcept
+			{
+				::operator delete(p, std::align_val_t(align));
+			}
+		};
+		struct Chunk
+		{
+			std::unique_ptr<unsigned char, AlignedDeleter> buffer;
+			std::size_t size = 0;
+		};
+		ComponentBitSet signature_;
+		std::vector<const ChunkTypeInfo*> types_;
+		std::vector<std::size_t> offsets_;
+		std::array<std::size_t, MaxComponents> column_;
+		std::size_t capacity_ = 0;
+		std::size_t chunkBytes_ = 0;
+		//!チャンクの先頭のアラインメント。格納する型のうち最大のものに合わせます
+		std::size_t chunkAlign_ = alignof(Entity*);
+		std::vector<Chunk> chunks_;
+
+		//!capacity個の要素を格納したときの各配列の先頭位置を計算し、必要なバイト数を返します
+		std::size_t calcLayout(const std::size_t capacity)
+		{
+			std::size_t offset = sizeof(Entity*) * capacity;
+			for (std::size_t i = 0; i < types_.size(); ++i)
+			{
+				const auto align = types_[i]->align;
+				offset = (offset + align - 1) / align * align;
+				offsets_[i] = offset;
+				offset += types_[i]->size * capacity;
+			}
+			return offset;
+		}
+		[[nodiscard]] Entity** entities(const Chunk& chunk) const
+		{
+			return reinterpret_cast<Entity**>(chunk.buffer.get());
+		}
+		[[nodiscard]] void* at(const Chunk& chunk, const std::size_t col, const std::size_t row) const
+		{
+			return chunk.buffer.get() + offsets_[col] + types_[col]->size * row;
+		}
+		//!末尾に行を確保し、その位置を返します。コンポーネントは未構築の状態です
+		std::pair<std::size_t, std::size_t> allocateRow(Entity* pEntity)
+		{
+			if (chunks_.empty() || chunks_.back().size == capacity_)
+			{
+				Chunk chunk{ std::unique_ptr<unsigned char, AlignedDeleter>(
+					static_cast<unsigned char*>(::operator new(chunkBytes_, std::align_val_t(chunkAlign_))),
+					AlignedDeleter{ chunkAlign_ }) };
+				chunks_.emplace_back(std::move(chunk));
+			}
+			auto& chunk = chunks_.back();
+			entities(chunk)[chunk.size] = pEntity;
+			return { chunks_.size() - 1, chunk.size++ };
+		}
+		/**
+		* @brief 指定した行のコンポーネントを破棄し、末尾の行で穴を埋めます
+		* @return Entity* 穴埋めのために移動したEntity、移動がなければnullptr
+		*/
+		Entity* removeRow(const std::size_t chunkIndex, const std::size_t row)
+		{
+			auto& chunk = chunks_[chunkIndex];
+			auto& last = chunks_.back();
+			const std::size_t lastRow = last.size - 1;
+			Entity* moved = nullptr;
+			for (std::size_t col = 0; col < types_.size(); ++col)
+			{
+				types_[col]->destroy(at(chunk, col, row));
+			}
+			if (&chunk != &last || row != lastRow)
+			{
+				for (std::size_t col = 0; col < types_.size(); ++col)
+				{
+					types_[col]->move(at(chunk, col, row), at(last, col, lastRow));
+					types_[col]->destroy(at(last, col, lastRow));
+				}
+				moved = entities(last)[lastRow];
+				entities(chunk)[row] = moved;
+			}
+			--last.size;
+			if (last.size == 0)
+			{
+				chunks_.pop_back();
+			}
+			return moved;
+		}
+	public:
+		ChunkArchetype(const ComponentBitSet& signature, std::vector<const ChunkTypeInfo*> types) :
+			signature_(signature),
+			types_(std::move(types))
+		{
+			std::sort(types_.begin(), types_.end(),
+				[](const ChunkTypeInfo* a, const ChunkTypeInfo* b) { return a->id < b->id; });
+			offsets_.resize(types_.size());
+			column_.fill(NONE);
+			std::size_t rowBytes = sizeof(Entity*);
+			for (std::size_t i = 0; i < types_.size(); ++i)
+			{
+				chunkAlign_ = (std::max)(chunkAlign_, types_[i]->align);
+				column_[types_[i]->id] = i;
+				rowBytes += types_[i]->size;
+			}
+			capacity_ = std::max<std::size_t>(ChunkByteSize / rowBytes, 1);
+			while (capacity_ > 1 && calcLayout(capacity_) > ChunkByteSize)
+			{
+				--capacity_;
+			}
+			chunkBytes_ = (std::max)(calcLayout(capacity_), ChunkByteSize);
+		}
+		ChunkArchetype(const ChunkArchetype&) = delete;
+		ChunkArchetype& operator=(const ChunkArchetype&) = delete;
+		~ChunkArchetype()
+		{
+			for (auto& chunk : chunks_)
+			{
+				for (std::size_t row = 0; row < chunk.size; ++row)
+				{
+					for (std::size_t col = 0; col < types_.size(); ++col)
+					{
+						types_[col]->destroy(at(chunk, col, row));
+					}
+				}
+			}
+		}
+		//!このアーキタイプのシグネチャを返します
+		[[nodiscard]] const ComponentBitSet& getSignature() const noexcept { return signature_; }
+		//!チャンク1つに格納できるEntityの数を返します
+		[[nodiscard]] std::size_t getChunkCapacity() const noexcept { return capacity_; }
+		//!使用中のチャンク数を返します
+		[[nodiscard]] std::size_t getChunkCount() const noexcept { return chunks_.size(); }
+		//!格納しているEntityの数を返します
+		[[nodiscard]] std::size_t size() const noexcept
+		{
+			return chunks_.empty() ? 0 : (chunks_.size() - 1) * capacity_ + chunks_.back().size;
+		}
+	};
+
+	/**
+	* @brief コンポーネントをアーキタイプごとのチャンクに詰めて保持するストレージです
+	* @details Entityのコンポーネントの組み合わせ(ComponentBitSet)ごとにChunkArchetypeを作り、
+	* 同じ型のコンポーネントはチャンク内で連続したメモリに並びます
+	* - Entity::addComponentとは別の保持方法です。こちらで追加したコンポーネントはEntity::hasComponentやEntityManager::view()では判定できません。
+	* 取得と走査はこのクラスのgetComponent()、each()、eachChunk()で行います
+	* - ComponentSystemを継承したコンポーネントは、EntityManagerのupdate()、updateByType()、draw2D()、draw3D()から
+	* アーキタイプのチャンクごと、型ごとに連続した配列のまま呼ばれます
+	* - Entityはチャンク内の位置を持っているので、取得はハッシュマップを引かずに行えます
+	* - チャンクは格納する型のうち最大のアラインメントで確保するので、アラインメントの大きい型も格納できます
+	* - コンポーネントは例外を投げずにムーブできる必要があります
+	* - 追加や削除でコンポーネントは移動するので、取得した参照やポインタを保持しないでください
+	* - each()やコンポーネントのupdate()の中でaddComponent()やremoveComponent()をしないでください。CommandBufferに記録してください
+	*/
+	class ChunkStorage final
+	{
+	private:
+		using Location = Entity::ChunkLocation;
+		std::vector<std::unique_ptr<ChunkArchetype>> archetypes_;
+		std::unordered_map<ComponentBitSet, ChunkArchetype*> archetypeMap_;
+		std::size_t size_ = 0;
+
+		//!シグネチャに一致するアーキタイプを返します。なければ作ります
+		ChunkArchetype& getArchetype(const ComponentBitSet& signature, const ChunkArchetype* base, const ChunkTypeInfo* add)
+		{
+			const auto it = archetypeMap_.find(signature);
+			if (it != archetypeMap_.end())
+			{
+				return *it->second;
+			}
+			std::vector<const ChunkTypeInfo*> types;
+			if (base != nullptr)
+			{
+				for (const auto& info : base->types_)
+				{
+					if (signature[info->id])
+					{
+						types.emplace_back(info);
+					}
+				}
+			}
+			if (add != nullptr)
+			{
+				types.emplace_back(add);
+			}
+			archetypes_.emplace_back(std::make_unique<ChunkArchetype>(signature, std::move(types)));
+			archetypeMap_[signature] = archetypes_.back().get();
+			return *archetypes_.back();
+		}
+		//!行を削除し、穴埋めで移動したEntityの位置を更新します
+		void eraseRow(const Location& loc)
+		{
+			if (Entity* moved = loc.archetype->removeRow(loc.chunk, loc.row))
+			{
+				moved->chunkLocation_ = loc;
+			}
+		}
+		//!アーキタイプを移動し、共通するコンポーネントをムーブします
+		Location moveEntity(Entity* pEntity, const Location& from, ChunkArchetype& to)
+		{
+			const auto pos = to.allocateRow(pEntity);
+			const Location loc{ &to, pos.first, pos.second };
+			const auto& src = from.archetype->chunks_[from.chunk];
+			auto& dst = to.chunks_[loc.chunk];
+			for (std::size_t col = 0; col < from.archetype->types_.size(); ++col)
+			{
+				const auto dstCol = to.column_[from.archetype->types_[col]->id];
+				if (dstCol != ChunkArchetype::NONE)
+				{
+					from.archetype->types_[col]->move(to.at(dst, dstCol, loc.row), from.archetype->at(src, col, from.row));
+				}
+			}
+			eraseRow(from);
+			return loc;
+		}
+		//!すべてのアーキタイプについて、型ごとにチャンク内の配列をまとめて処理します
+		void eachColumn(const ChunkTypeInfo::ColumnFunc ChunkTypeInfo::* func)
+		{
+			for (auto& archetype : archetypes_)
+			{
+				for (std::size_t col = 0; col < archetype->types_.size(); ++col)
+				{
+					const auto f = archetype->types_[col]->*func;
+					if (f == nullptr)
+					{
+						continue;
+					}
+					for (auto& chunk : archetype->chunks_)
+					{
+						f(archetype->at(chunk, col, 0), chunk.size);
+					}
+				}
+			}
+		}
+		template <typename... Ts>[[nodiscard]] static ComponentBitSet MakeSignature()
+		{
+			ComponentBitSet signature;
+			(signature.set(GetComponentTypeID<Ts>()), ...);
+			return signature;
+		}
+	public:
+		ChunkStorage() = default;
+		ChunkStorage(const ChunkStorage&) = delete;
+		ChunkStorage& operator=(const ChunkStorage&) = delete;
+
+		//!Entityが指定したコンポーネントをチャンクに持っているか返します
+		template <typename T>[[nodiscard]] bool hasComponent(const Entity& entity) const
+		{
+			const auto* archetype = entity.chunkLocation_.archetype;
+			return archetype != nullptr && archetype->signature_[GetComponentTypeID<T>()];
+		}
+
+		/**
+		* @brief コンポーネントをチャンクに追加します
+		* @param entity 追加先のEntity
+		* @param args コンポーネントのコンストラクタと同じものになります
+		* @return T 追加したコンポーネントの参照
+		* @details Entityはコンポーネントの組み合わせが一致するアーキタイプへ移動します
+		* - 重複はできません。重複した場合はそのコンポーネントが返ります
+		* - ComponentSystemを継承した型の場合はownerがセットされますが、initialize()は呼ばれません
+		* - コンポーネントは先に一時オブジェクトとして作るので、コンストラクタが例外を投げてもEntityの行は移動しません
+		*/
+		template <typename T, typename... TArgs> T& addComponent(Entity& entity, TArgs&&... args)
+		{
+			const auto& info = GetChunkTypeInfo<T>();
+			const Location from = entity.chunkLocation_;
+			ComponentBitSet signature;
+			if (from.archetype != nullptr)
+			{
+				if (from.archetype->signature_[info.id])
+				{
+					std::cerr << "addComponent is failed" << std::endl;
+					return getComponent<T>(entity);
+				}
+				signature = from.archetype->signature_;
+			}
+			T value(std::forward<TArgs>(args)...);
+			signature[info.id] = true;
+			auto& to = getArchetype(signature, from.archetype, &info);
+			Location loc;
+			if (from.archetype != nullptr)
+			{
+				loc = moveEntity(&entity, from, to);
+			}
+			else
+			{
+				const auto pos = to.allocateRow(&entity);
+				loc = Location{ &to, pos.first, pos.second };
+				++size_;
+			}
+			entity.chunkLocation_ = loc;
+			T* c = new(to.at(to.chunks_[loc.chunk], to.column_[info.id], loc.row)) T(std::move(value));
+			if constexpr (std::is_base_of_v<ComponentSystem, T>)
+			{
+				c->owner = &entity;
+			}
+			return *c;
+		}
+
+		//!指定したコンポーネントをチャンクから削除します
+		template <typename T> void removeComponent(Entity& entity)
+		{
+			if (!hasComponent<T>(entity))
+			{
+				return;
+			}
+			const Location from = entity.chunkLocation_;
+			auto signature = from.archetype->signature_;
+			signature[GetComponentTypeID<T>()] = false;
+			if (signature.none())
+			{
+				removeEntity(entity);
+				return;
+			}
+			auto& to = getArchetype(signature, from.archetype, nullptr);
+			entity.chunkLocation_ = moveEntity(&entity, from, to);
+		}
+
+		//!Entityがチャンクに持っているコンポーネントをすべて削除します
+		void removeEntity(Entity& entity)
+		{
+			const Location loc = entity.chunkLocation_;
+			if (loc.archetype == nullptr)
+			{
+				return;
+			}
+			entity.chunkLocation_ = Location{};
+			--size_;
+			eraseRow(loc);
+		}
+
+		/**
+		* @brief チャンクに格納されたコンポーネントを取得します
+		* @return T 指定したコンポーネントの参照
+		* @details 追加や削除を行うと参照は無効になります
+		*/
+		template <typename T>[[nodiscard]] T& getComponent(const Entity& entity) const
+		{
+			if (!hasComponent<T>(entity))
+			{
+				std::cout << typeid(T).name() << std::endl;
+				assert(hasComponent<T>(entity));
+			}
+			const auto& loc = entity.chunkLocation_;
+			const auto& chunk = loc.archetype->chunks_[loc.chunk];
+			return *static_cast<T*>(loc.archetype->at(chunk, loc.archetype->column_[GetComponentTypeID<T>()], loc.row));
+		}
+
+		/**
+		* @brief 指定したコンポーネントをすべて持つEntityを走査します
+		* @param func void(Entity&, Ts&...)の関数
+		* @details 条件に一致するアーキタイプのチャンクを先頭から順に走査します
+		*/
+		template <typename... Ts, typename Func> void each(Func&& func)
+		{
+			eachChunk<Ts...>([&func](const std::size_t size, Entity* const* entities, Ts*... arrays)
+			{
+				for (std::size_t i = 0; i < size; ++i)
+				{
+					func(*entities[i], arrays[i]...);
+				}
+			});
+		}
+
+		/**
+		* @brief 指定したコンポーネントをすべて持つチャンクを走査します
+		* @param func void(std::size_t 要素数, Entity* const* Entityの配列, Ts*... コンポーネントの配列)の関数
+		* @details 配列は要素数分連続しているので、まとめて処理したい場合はこちらを使います
+		*/
+		template <typename... Ts, typename Func> void eachChunk(Func&& func)
+		{
+			const auto signature = MakeSignature<Ts...>();
+			for (auto& archetype : archetypes_)
+			{
+				if (!archetype->signature_.containsAll(signature))
+				{
+					continue;
+				}
+				for (auto& chunk : archetype->chunks_)
+				{
+					func(chunk.size, archetype->entities(chunk),
+						static_cast<Ts*>(archetype->at(chunk, archetype->column_[GetComponentTypeID<Ts>()], 0))...);
+				}
+			}
+		}
+
+		//!ComponentSystemを継承したコンポーネントを型ごとにまとめて更新します。停止しているコンポーネントは更新されません
+		void update()
+		{
+			eachColumn(&ChunkTypeInfo::update);
+		}
+		//!ComponentSystemを継承したコンポーネントを型ごとにまとめて2D描画します
+		void draw2D()
+		{
+			eachColumn(&ChunkTypeInfo::draw2D);
+		}
+		//!ComponentSystemを継承したコンポーネントを型ごとにまとめて3D描画します
+		void draw3D()
+		{
+			eachColumn(&ChunkTypeInfo::draw3D);
+		}
+
+		//!チャンクにコンポーネントを持っているEntityの数を返します
+		[[nodiscard]] std::size_t size() const noexcept { return size_; }
+		//!チャンクにコンポーネントを持っているEntityがいないか返します
+		[[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+		//!作成済みのアーキタイプを返します
+		[[nodiscard]] const std::vector<std::unique_ptr<ChunkArchetype>>& getArchetypes() const noexcept { return archetypes_; }
+	};
+
+	/**
+	* @brief Entityの生成や削除、コンポーネントの追加や削除を記録し、後でまとめて実行します
+	* @details 更新処理の途中でEntityやコンポーネントを増減させたい場合に使います
+	* - 記録はスレッドセーフなので、ワーカースレッドからも記録できます
+	* - 記録した処理はEntityManager::refresh()の最初にまとめて実行されます
+	* - 実行は生成、コンポーネントの追加と削除(Entityごとに記録順)、Entityの削除の順に行います
+	* - 実行時にすでに削除されていたEntityへの処理は無視されます
+	*/
+	class CommandBuffer final
+	{
+	private:
+		friend class EntityManager;
+		enum class Kind
+		{
+			CREATE,
+			MODIFY,
+			DESTROY,
+		};
+		struct Command
+		{
+			Kind kind;
+			EntityId id;
+			Group group;
+			bool hasGroup;
+			std::function<void(Entity&)> func;
+		};
+		std::mutex mutex_;
+		std::vector<Command> commands_;
+		std::vector<Command> executing_;
+
+		void push(Command&& command)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			commands_.emplace_back(std::move(command));
+		}
+		//!記録した処理をすべて実行します
+		void playback(EntityManager& manager);
+	public:
+		CommandBuffer() = default;
+		CommandBuffer(const CommandBuffer&) = delete;
+		CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+		/**
+		* @brief Entityの生成を記録します
+		* @param init 生成直後に呼ばれる関数です。コンポーネントの追加などを行ってください
+		*/
+		void createEntity(std::function<void(Entity&)> init)
+		{
+			push(Command{ Kind::CREATE, EntityId{}, 0u, false, std::move(init) });
+		}
+		/**
+		* @brief グループに属するEntityの生成を記録します
+		* @param group 属するグループ
+		* @param init 生成直後に呼ばれる関数です。コンポーネントの追加などを行ってください
+		*/
+		void createEntity(const Group group, std::function<void(Entity&)> init)
+		{
+			push(Command{ Kind::CREATE, EntityId{}, group, true, std::move(init) });
+		}
+		//!Entityの削除を記録します
+		void destroyEntity(const EntityId& id)
+		{
+			push(Command{ Kind::DESTROY, id, 0u, false, nullptr });
+		}
+		/**
+		* @brief コンポーネントの追加を記録します
+		* @param id 追加先のEntity
+		* @param args コンポーネントのコンストラクタと同じものになります。コピーして保持されます
+		*/
+		template <typename T, typename... TArgs> void addComponent(const EntityId& id, TArgs&&... args)
+		{
+			push(Command{ Kind::MODIFY, id, 0u, false,
+				[tuple = std::make_tuple(std::forward<TArgs>(args)...)](Entity& entity) mutable
+			{
+				std::apply([&entity](auto&... a) { entity.addComponent<T>(std::move(a)...); }, tuple);
+			} });
+		}
+		//!コンポーネントの削除を記録します
+		template <typename T> void removeComponent(const EntityId& id)
+		{
+			push(Command{ Kind::MODIFY, id, 0u, false, [](Entity& entity) { entity.removeComponent<T>(); } });
+		}
+		//!記録されている処理の数を返します
+		[[nodiscard]] std::size_t size()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return commands_.size();
+		}
+	};
+
+	/**
+	* @brief Entityの構成を1度だけ組み立てておく設計図です
+	* @details 追加するコンポーネントとその引数、グループを記録し、EntityManager::instantiate()で何体でも生成できます
+	* - コピーできるコンポーネントはadd()の時点で1つ作っておき、生成時はそれをコピーします。
+	*   コンストラクタでのリソースの検索などは1度しか行われません
+	* - コピーできないコンポーネントは引数を保持し、生成時にコンストラクタを呼びます
+	* - コンポーネントはadd()した順に追加され、それぞれinitialize()が呼ばれます
+	*/
+	class Prefab final
+	{
+	private:
+		friend class EntityManager;
+		struct Recipe
+		{
+			ComponentID id;
+			void(*reserve)(std::size_t count);
+			std::function<void(Entity&)> build;
+		};
+		std::vector<Recipe> recipes_;
+		Group group_ = 0;
+		bool hasGroup_ = false;
+	public:
+		Prefab() = default;
+		//!生成したEntityを登録するグループを指定します
+		explicit Prefab(const Group& group) :
+			group_(group),
+			hasGroup_(true)
+		{}
+		/**
+		* @brief コンポーネントを追加します
+		* @param args コンポーネントのコンストラクタと同じものになります
+		* @return Prefab& 続けてadd()できるように自身を返します
+		*/
+		template <typename T, typename... TArgs> Prefab& add(TArgs&&... args)
+		{
+			Recipe recipe;
+			recipe.id = GetComponentTypeID<T>();
+			recipe.reserve = [](const std::size_t count)
+			{
+				auto& pool = BlockPool<T>::Get();
+				pool.reserve(pool.getStats().live + count);
+			};
+			if constexpr (std::is_copy_constructible_v<T>)
+			{
+				auto prototype = std::make_shared<const T>(std::forward<TArgs>(args)...);
+				recipe.build = [prototype](Entity& e) { e.addComponent<T>(*prototype); };
+			}
+			else
+			{
+				recipe.build = [params = std::make_tuple(std::decay_t<TArgs>(std::forward<TArgs>(args))...)](Entity& e)
+				{
+					std::apply([&e](const auto&... a) { e.addComponent<T>(a...); }, params);
+				};
+			}
+			recipes_.emplace_back(std::move(recipe));
+			return *this;
+		}
+		//!タグを追加します
+		template <typename T> Prefab& addTag()
+		{
+			Recipe recipe;
+			recipe.id = GetComponentTypeID<T>();
+			recipe.reserve = [](std::size_t) {};
+			recipe.build = [](Entity& e) { e.addTag<T>(); };
+			recipes_.emplace_back(std::move(recipe));
+			return *this;
+		}
+		//!共有コンポーネントを設定します。生成したEntityはすべてsharedを参照します
+		template <typename T> Prefab& setShared(Shared<T>& shared)
+		{
+			Recipe recipe;
+			recipe.id = GetComponentTypeID<Shared<T>>();
+			recipe.reserve = [](std::size_t) {};
+			recipe.build = [pShared = &shared](Entity& e) { e.setShared(*pShared); };
+			recipes_.emplace_back(std::move(recipe));
+			return *this;
+		}
+		//!生成したEntityを登録するグループを指定します
+		Prefab& setGroup(const Group& group) noexcept
+		{
+			group_ = group;
+			hasGroup_ = true;
+			return *this;
+		}
+		//!追加したコンポーネントの数を返します
+		[[nodiscard]] std::size_t size() const noexcept { return recipes_.size(); }
+	};
+
+	/**
+	* @brief 死んだEntityをコンポーネントごと保持し、次の生成で再利用するプールです
+	* @details EntityManager::createEntityPool()で作ります。弾やエフェクトのように頻繁に生成と削除を繰り返すEntityに使います
+	* - このプールで生成したEntityはdestroy()されるとrefresh()でマネージャーから外れ、コンポーネントを持ったまま眠ります
+	* - 眠るときは各コンポーネントのonSleep()を呼びます
+	* - 再利用時はinitialize()を呼ばず、各コンポーネントのonRecycle()とプールのリセット関数を呼びます
+	* - 再利用されたEntityは新しいハンドルを持つので、以前のハンドルは無効のままです
+	* - 眠っている間はビューやグループ、更新と描画の対象になりません
+	*/
+	class EntityPool final
+	{
+	private:
+		friend class EntityManager;
+		EntityManager& manager_;
+		Prefab prefab_;
+		std::function<void(Entity&)> resetFunc_;
+		std::vector<EntityPtr> sleeping_;
+	public:
+		EntityPool(EntityManager& manager, const Prefab& prefab, std::function<void(Entity&)> resetFunc) :
+			manager_(manager),
+			prefab_(prefab),
+			resetFunc_(std::move(resetFunc))
+		{}
+		EntityPool(const EntityPool&) = delete;
+		EntityPool& operator=(const EntityPool&) = delete;
+
+		/**
+		* @brief Entityをcount体生成します。眠っているEntityがあれば優先して再利用します
+		* @param initFunc void(Entity&, std::size_t 何体目か)の関数
+		*/
+		template <typename Func> void spawn(const std::size_t count, Func&& initFunc);
+		//!Entityを1体生成します
+		Entity& spawn();
+		//!count体を先に生成して眠らせておきます。次のrefresh()から再利用できます
+		void prewarm(const std::size_t count);
+		//!眠っているEntityの数を返します
+		[[nodiscard]] std::size_t getSleepingCount() const noexcept { return sleeping_.size(); }
+	};
+
+	/**
+	* @brief Entity統括クラスです
+	* @details Entityの生成と管理を行います。グループへの登録もこのクラスが行います
+	*/
+	class EntityManager final
+	{
+	private:
+		friend class Entity;
+		friend class EntityPool;
+		friend class Snapshot;
+		//共有コンポーネントはEntityから参照されるので、Entityより後に破棄されるよう先に宣言する
+		std::vector<std::unique_ptr<ComponentSystem>> sharedComponents_;
+		//コンポーネントから参照されるので、Entityより後に破棄されるよう先に宣言する
+		TransformHierarchy transformHierarchy_;
+		//眠っているEntityを持つので、Entityより後に破棄されるよう先に宣言する
+		std::vector<std::unique_ptr<EntityPool>> entityPools_;
+		std::vector<EntityPtr> entityes_;
+		std::vector<std::unique_ptr<IEvents>> events_;
+		std::mutex eventsMutex_;
+		std::vector<Entity*> deadEntities_;
+		std::vector<Entity*> componentRemovedEntities_;
+		std::vector<std::unique_ptr<Query>> queries_;
+		std::vector<std::pair<ComponentID, std::unique_ptr<IComponentHistory>>> histories_;
+		//!コンポーネントの型ごとの処理時間(ナノ秒)と呼び出し回数。並列に更新されることがあるのでアトミックにする
+		struct ComponentCost
+		{
+			std::atomic<std::int64_t> updateTime{ 0 };
+			std::atomic<std::int64_t> draw2DTime{ 0 };
+			std::atomic<std::int64_t> draw3DTime{ 0 };
+			std::atomic<std::size_t> updateCalls{ 0 };
+			std::atomic<std::size_t> draw2DCalls{ 0 };
+			std::atomic<std::size_t> draw3DCalls{ 0 };
+		};
+		std::array<ComponentCost, MaxComponents> costs_;
+		bool isProfiling_ = false;
+		//!グループかコンポーネントが変わり、クエリで判定し直すEntity
+		std::vector<Entity*> queryDirtyEntities_;
+		//!コンポーネントの型ごとのオブザーバーと、次のrefresh()で通知するEntity
+		struct ComponentObserver
+		{
+			using Func = std::function<void(const std::vector<Entity*>&)>;
+			std::vector<Func> onAdd;
+			std::vector<Func> onRemove;
+			std::vector<Func> onDestroy;
+			std::vector<Entity*> added;
+			std::vector<Entity*> removed;
+		};
+		std::array<std::unique_ptr<ComponentObserver>, MaxComponents> observers_;
+		ComponentBitSet destroyObserved_;
+		//!通知の最中に行われた登録と解除。listがnullptrなら解除
+		struct PendingObserver
+		{
+			ComponentID id;
+			std::vector<ComponentObserver::Func> ComponentObserver::* list;
+			ComponentObserver::Func func;
+		};
+		std::vector<PendingObserver> pendingObservers_;
+		//!通知の最中に解除された型。通知が終わるまで残りの関数を呼ばない
+		ComponentBitSet clearedObservers_;
+		bool isDispatchingObservers_ = false;
+		GroupBitSet dirtyGroups_;
+		std::vector<std::pair<ComponentID, std::size_t(*)(const ComponentPool&)>> updateOrder_;
+		ComponentBitSet orderedComponents_;
+		//!更新処理を持たないタグと共有コンポーネントの型
+		ComponentBitSet passiveComponents_;
+		std::size_t reclaimedCount_ = 0u;
+		std::atomic<ChangeTick> changeTick_{ 1u };
+		std::array<std::vector<Entity*>, MaxGroups> groupedEntities_;
+		std::array<ComponentPool, MaxComponents> componentPools_;
+		struct Slot
+		{
+			Entity* entity = nullptr;
+			std::uint32_t generation = 1u;
+		};
+		std::vector<Slot> slots_;
+		std::vector<std::uint32_t> freeSlots_;
+		ChunkStorage chunkStorage_;
+		CommandBuffer commandBuffer_;
+		//!Entityにスロットを割り当てます。空きスロットがあれば再利用します
+		void assignSlot(Entity& entity)
+		{
+			std::uint32_t index;
+			if (freeSlots_.empty())
+			{
+				index = static_cast<std::uint32_t>(slots_.size());
+				slots_.emplace_back();
+			}
+			else
+			{
+				index = freeSlots_.back();
+				freeSlots_.pop_back();
+			}
+			slots_[index].entity = &entity;
+			entity.id_ = EntityId{ index, slots_[index].generation };
+		}
+		//!Entityを生成して登録します
+		Entity& createEntity()
+		{
+			Entity* e = BlockPool<Entity>::Get().create(*this);
+			assignSlot(*e);
+			e->position_ = entityes_.size();
+			entityes_.emplace_back(EntityPtr(e));
+			return *e;
+		}
+		//!destroy()されたEntityを次のrefresh()で削除するために記録します
+		void markDead(Entity& entity) noexcept
+		{
+			deadEntities_.emplace_back(&entity);
+			dirtyGroups_ |= entity.groupBitSet_;
+			markQueryDirty(entity);
+		}
+		//!クエリがあれば、グループかコンポーネントが変わったEntityを記録します
+		void markQueryDirty(Entity& entity)
+		{
+			if (!queries_.empty() && !entity.isQueryDirty_)
+			{
+				entity.isQueryDirty_ = true;
+				queryDirtyEntities_.emplace_back(&entity);
+			}
+		}
+		//!記録したEntityをクエリで判定し直します
+		void updateQueries()
+		{
+			for (const auto& e : queryDirtyEntities_)
+			{
+				e->isQueryDirty_ = false;
+				for (const auto& q : queries_)
+				{
+					q->update(e, e->isActive_ && q->matches(e->componentBitSet_, e->groupBitSet_));
+				}
+			}
+			queryDirtyEntities_.clear();
+		}
+		//!コンポーネントが削除されたEntityを記録します
+		void markComponentRemoved(Entity& entity)
+		{
+			componentRemovedEntities_.emplace_back(&entity);
+		}
+		//!オブザーバーがいればコンポーネントが追加されたことを記録します
+		void markComponentAdded(const ComponentID id, Entity& entity)
+		{
+			if (observers_[id] != nullptr && !observers_[id]->onAdd.empty())
+			{
+				observers_[id]->added.emplace_back(&entity);
+			}
+		}
+		//!オブザーバーがいればコンポーネントが削除されたことを記録します
+		void markComponentUnregistered(const ComponentID id, Entity& entity)
+		{
+			if (observers_[id] != nullptr && !observers_[id]->onRemove.empty())
+			{
+				observers_[id]->removed.emplace_back(&entity);
+			}
+		}
+		//!指定した型のオブザーバーを返します。なければ作ります
+		ComponentObserver& getObserver(const ComponentID id)
+		{
+			if (observers_[id] == nullptr)
+			{
+				observers_[id] = std::make_unique<ComponentObserver>();
+			}
+			return *observers_[id];
+		}
+		//!オブザーバーに関数を登録します。通知の最中であれば通知が終わるまで遅らせます
+		void addObserver(const ComponentID id, std::vector<ComponentObserver::Func> ComponentObserver::* list, ComponentObserver::Func&& func)
+		{
+			if (isDispatchingObservers_)
+			{
+				pendingObservers_.emplace_back(PendingObserver{ id, list, std::move(func) });
+				return;
+			}
+			(getObserver(id).*list).emplace_back(std::move(func));
+			if (list == &ComponentObserver::onDestroy)
+			{
+				destroyObserved_.set(id);
+			}
+		}
+		//!オブザーバーを解除します。通知の最中であれば呼び出し中の関数を壊さないよう、通知が終わるまで遅らせます
+		void removeObserver(const ComponentID id)
+		{
+			if (isDispatchingObservers_)
+			{
+				clearedObservers_.set(id);
+				pendingObservers_.emplace_back(PendingObserver{ id, nullptr, nullptr });
+				return;
+			}
+			observers_[id].reset();
+			destroyObserved_.reset(id);
+		}
+		//!記録した追加、削除、Entityの削除をオブザーバーに通知します
+		void dispatchObservers();
+		/**
+		* @brief 指定した型のコンポーネントをまとめて更新します
+		* @details 型が確定しているので仮想関数を経由せずに呼び出します
+		* - 末尾から処理するので、更新中に同じ型のコンポーネントが削除されても安全です
+		* @return std::size_t 実際にupdate()を呼んだ数
+		*/
+		template <typename T> static std::size_t UpdateComponents(const ComponentPool& pool)
+		{
+			std::size_t calls = 0;
+			if constexpr (!std::is_base_of_v<ComponentData, T>)
+			{
+				const auto& components = pool.getComponents();
+				for (std::size_t i = components.size(); i-- > 0;)
+				{
+					if (i >= components.size())
+					{
+						continue;
+					}
+					T* c = static_cast<T*>(components[i]);
+					if (!c->isStop())
+					{
+						c->T::update();
+						++calls;
+					}
+				}
+			}
+			return calls;
+		}
+		//!計測に使う時刻をナノ秒で返します
+		[[nodiscard]] static std::int64_t ProfileNow() noexcept
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+		//!グループから外れたEntityがいることを記録します
+		void markGroupDirty(const Group& group) noexcept
+		{
+			dirtyGroups_[group] = true;
+		}
+		//!死んだEntityをスパースセットから外し、スロットを返却します
+		void releaseEntity(const Entity& entity)
+		{
+			entity.componentBitSet_.each([&](const std::size_t id)
+			{
+				componentPools_[id].remove(entity.id_.index);
+			});
+			auto& slot = slots_[entity.id_.index];
+			slot.entity = nullptr;
+			//世代0は無効なハンドルに使うので飛ばす
+			if (++slot.generation == 0u)
+			{
+				slot.generation = 1u;
+			}
+			freeSlots_.emplace_back(entity.id_.index);
+		}
+		//!眠っていたEntityを登録し直します
+		Entity& reviveEntity(EntityPtr pEntity)
+		{
+			Entity& e = *pEntity;
+			assignSlot(e);
+			e.isActive_ = true;
+			e.position_ = entityes_.size();
+			entityes_.emplace_back(std::move(pEntity));
+			const ChangeTick tick = getChangeTick();
+			for (const auto& c : e.components_)
+			{
+				if (c == nullptr)
+				{
+					continue;
+				}
+				componentPools_[c->typeID_].add(e.id_.index, &e, c.get(), tick);
+				markComponentAdded(c->typeID_, e);
+			}
+			//実体を持たないタグはシグネチャから登録し直す
+			e.componentBitSet_.each([&](const std::size_t id)
+			{
+				if (!componentPools_[id].contains(e.id_.index))
+				{
+					componentPools_[id].add(e.id_.index, &e, nullptr, tick);
+					markComponentAdded(id, e);
+				}
+			});
+			e.groupBitSet_.each([&](const std::size_t group)
+			{
+				addToGroup(&e, group);
+			});
+			markQueryDirty(e);
+			for (const auto& c : e.components_)
+			{
+				if (c != nullptr && c->owner == &e)
+				{
+					c->onRecycle();
+				}
+			}
+			return e;
+		}
+	public:
+		EntityManager()
+		{
+			
+		}
+		//!登録されているEntityの初期化を行います
+		void initialize()
+		{
+			for (auto& e : entityes_) e->initialize();
+		}
+		/**
+		* @brief 登録されているEntityの更新を行います
+		* @details 続けてChunkStorageのコンポーネントを型ごとに更新し、最後にTransform2Dの親子関係を反映します
+		*/
+		void update()
+		{
+			for (auto& e : entityes_)
+			{
+				if (e == nullptr)
+				{
+					continue;
+				}
+				e->update();
+			}
+			chunkStorage_.update();
+			transformHierarchy_.update();
+		}
+
+		/**
+		* @brief コンポーネントの型ごとの更新順を指定します
+		* @details setUpdateOrder<Physics2D, Transform2D, LineCollider>();のように使います
+		* - updateByType()で使われます。指定しなかった型は指定した型の後に更新されます
+		*/
+		template <typename... Ts> void setUpdateOrder()
+		{
+			updateOrder_.clear();
+			orderedComponents_.reset();
+			(updateOrder_.emplace_back(GetComponentTypeID<Ts>(), &UpdateComponents<Ts>), ...);
+			(orderedComponents_.set(GetComponentTypeID<Ts>()), ...);
+		}
+
+		/**
+		* @brief 登録されているコンポーネントを型ごとにまとめて更新します
+		* @details Entityごとではなく、同じ型のコンポーネントを続けて更新するので分岐予測や命令キャッシュが効きやすくなります
+		* - update()の代わりに使います。停止しているコンポーネントは更新されません
+		* - setUpdateOrder()で指定した型から順に更新し、残りの型はID順に更新します
+		* - 同じEntityのコンポーネント同士の更新順は追加順にはなりません
+		* - 続けてChunkStorageのコンポーネントを更新し、最後にTransform2Dの親子関係を反映します
+		*/
+		void updateByType()
+		{
+			for (const auto& it : updateOrder_)
+			{
+				const std::int64_t begin = isProfiling_ ? ProfileNow() : 0;
+				const std::size_t calls = it.second(componentPools_[it.first]);
+				if (isProfiling_)
+				{
+					costs_[it.first].updateTime += ProfileNow() - begin;
+					costs_[it.first].updateCalls += calls;
+				}
+			}
+			for (std::size_t id = 0; id < MaxComponents; ++id)
+			{
+				if (orderedComponents_[id] || passiveComponents_[id])
+				{
+					continue;
+				}
+				const std::int64_t begin = isProfiling_ ? ProfileNow() : 0;
+				const auto& components = componentPools_[id].getComponents();
+				std::size_t calls = 0;
+				for (std::size_t i = components.size(); i-- > 0;)
+				{
+					if (i < components.size() && !components[i]->isStop())
+					{
+						components[i]->update();
+						++calls;
+					}
+				}
+				if (isProfiling_)
+				{
+					costs_[id].updateTime += ProfileNow() - begin;
+					costs_[id].updateCalls += calls;
+				}
+			}
+			chunkStorage_.update();
+			transformHierarchy_.update();
+		}
+
+		/**
+		* @brief 登録されているEntityの3D描画を行い、続けてChunkStorageのコンポーネントを型ごとに描画します
+		* @details Entityを削除するとrefresh()で並びが入れ替わるので、描画順は生成順とは限りません
+		*/
+		void draw3D()
+		{
+			for (auto& e : entityes_) e->draw3D();
+			chunkStorage_.draw3D();
+		}
+
+		/**
+		* @brief グループごとの描画を登録順に行います
+		* @param MaxGroup 最大グループ数
+		* @details グループ内の順番はrefresh()で削除しても保たれるので、DxLibの描画の重なり順を決める場合はこちらを使います
+		*/
+		void orderByDraw(const Group& MaxGroup)
+		{
+			for (auto i(0u); i < MaxGroup; ++i)
+			{
+				const auto& entity = groupedEntities_[i];
+				for (const auto& e : entity)
+				{
+					e->draw2D();
+				}
+			}
+		}
+		/**
+		* @brief 登録されているEntityの2D描画を行い、続けてChunkStorageのコンポーネントを型ごとに描画します
+		* @details Entityを削除するとrefresh()で並びが入れ替わるので、描画順は生成順とは限りません。重なり順はorderByDraw()で保ってください
+		*/
+		void draw2D()
+		{
+			for (auto& e : entityes_)
+			{
+				e->draw2D();
+			}
+			chunkStorage_.draw2D();
+		}
+		//!すべてのエンティティを削除します
+		void removeAll()
+		{
+			for (auto& e : entityes_)
+			{
+				e->destroy();
+			}
+		}
+		/**
+		* @brief アクティブでないEntityを削除します。必ず更新処理で呼んでください
+		* @details コストは削除するEntityの数と、Entityが外れたグループの要素数に比例します
+		* - Entityは末尾のEntityと入れ替えて削除するので、update()の更新順とdraw2D()、draw3D()の描画順は変わることがあります
+		* - グループ内の順番は保たれます。描画の重なり順が大事な場合はグループに登録してorderByDraw()で描画してください
+		*/
+		void refresh()
+		{
+			for (const auto& it : events_)
+			{
+				if (it != nullptr)
+				{
+					it->swap();
+				}
+			}
+			commandBuffer_.playback(*this);
+			for (const auto& e : componentRemovedEntities_)
+			{
+				e->refreshComponent();
+			}
+			componentRemovedEntities_.clear();
+			dispatchObservers();
+			updateQueries();
+			reclaimedCount_ = deadEntities_.size();
+			//描画順を保つため、グループは変更のあったものだけ順番を保って詰める
+			if (dirtyGroups_.any())
+			{
+				dirtyGroups_.each([&](const std::size_t i)
+				{
+					auto& v(groupedEntities_[i]);
+
+					v.erase(std::remove_if(std::begin(v), std::end(v),
+						[i](Entity* pEntity)
+					{
+						return !pEntity->isActive() ||
+							!pEntity->hasGroup(i);
+					}),
+						std::end(v));
+				});
+				dirtyGroups_.reset();
+			}
+
+			for (const auto& e : deadEntities_)
+			{
+				releaseEntity(*e);
+				chunkStorage_.removeEntity(*e);
+				//末尾のEntityと入れ替えて削除する
+				const std::size_t pos = e->position_;
+				if (pos != entityes_.size() - 1)
+				{
+					std::swap(entityes_[pos], entityes_.back());
+					entityes_[pos]->position_ = pos;
+				}
+				if (e->pool_ != nullptr)
+				{
+					for (const auto& c : e->components_)
+					{
+						if (c != nullptr && c->owner == e)
+						{
+							c->onSleep();
+						}
+					}
+					e->pool_->sleeping_.emplace_back(std::move(entityes_.back()));
+				}
+				entityes_.pop_back();
+			}
+			deadEntities_.clear();
+		}
+
+		//!直前のrefresh()で削除したEntityの数を返します
+		[[nodiscard]] std::size_t getReclaimedCount() const noexcept
+		{
+			return reclaimedCount_;
+		}
+
+		/**
+		* @brief チャンク形式でコンポーネントを保持するストレージを返します
+		* @details 大量のEntityが同じデータを持つ場合に使います。死んだEntityのデータはrefresh()で削除されます
+		*/
+		[[nodiscard]] ChunkStorage& getChunkStorage() noexcept
+		{
+			return chunkStorage_;
+		}
+		/**
+		* @brief Transform2Dの親子関係を管理するストアを返します
+		* @details SystemSchedulerなどでupdate()を使わない場合は、システムの実行後にupdate()を呼んでください
+		*/
+		[[nodiscard]] TransformHierarchy& getTransformHierarchy() noexcept
+		{
+			return transformHierarchy_;
+		}
+
+		//!ハンドルが指すEntityがまだ存在するか返します。destroy()されたEntityもrefresh()までは存在します
+		[[nodiscard]] bool isValid(const EntityId& id) const noexcept
+		{
+			return id.index < slots_.size() &&
+				slots_[id.index].generation == id.generation &&
+				slots_[id.index].entity != nullptr;
+		}
+
+		//!ハンドルが指すEntityを返します。すでに削除されている場合はnullptrが返ります
+		[[nodiscard]] Entity* getEntity(const EntityId& id) const noexcept
+		{
+			return isValid(id) ? slots_[id.index].entity : nullptr;
+		}
+
+		/**
+		* @brief 構造変更を記録するCommandBufferを返します
+		* @details 記録した処理は次のrefresh()の最初に実行されます
+		*/
+		[[nodiscard]] CommandBuffer& getCommandBuffer() noexcept
+		{
+			return commandBuffer_;
+		}
+
+		/**
+		* @brief EntityとComponentのブロックプールの使用状況を返します
+		* @details 生成済みのすべての型のプールが対象です。プールは型ごとに全マネージャーで共有されます
+		*/
+		[[nodiscard]] std::vector<BlockPoolStats> getPoolStats() const
+		{
+			return BlockPoolRegistry::GetStats();
+		}
+
+		/**
+		* @brief コンポーネントの処理時間の計測を切り替えます
+		* @details 計測中はEntityのupdate()、draw2D()、draw3D()でコンポーネントごとに、updateByType()では型ごとに時間を計ります
+		* - 計測していないときのコストはフラグの判定だけです
+		*/
+		void setProfiling(const bool isProfiling) noexcept
+		{
+			isProfiling_ = isProfiling;
+		}
+		//!コンポーネントの処理時間を計測しているか返します
+		[[nodiscard]] bool isProfiling() const noexcept { return isProfiling_; }
+		//!計測した処理時間と呼び出し回数を0に戻します。フレームごとの値が必要な場合は毎フレーム呼びます
+		void resetProfile() noexcept
+		{
+			for (auto& it : costs_)
+			{
+				it.updateTime = 0;
+				it.draw2DTime = 0;
+				it.draw3DTime = 0;
+				it.updateCalls = 0;
+				it.draw2DCalls = 0;
+				it.draw3DCalls = 0;
+			}
+		}
+		/**
+		* @brief コンポーネントの型ごとの統計を返します
+		* @details Entityが持っているか、処理時間が計測された型だけが対象です
+		*/
+		[[nodiscard]] std::vector<ComponentStats> getComponentStats() const;
+		//!コンポーネントの型ごとの統計をJSONの文字列で返します
+		[[nodiscard]] std::string getComponentStatsJson() const;
+		//!コンポーネントの型ごとの統計をJSONでファイルに書き出します
+		bool dumpComponentStats(const std::string& path) const;
+
+		//!指定したコンポーネントのスパースセットを返します
+		[[nodiscard]] ComponentPool& getComponentPool(const ComponentID id) noexcept
+		{
+			return componentPools_[id];
+		}
+
+		//!現在のティックを返します。コンポーネントの追加や変更はこのティックで記録されます
+		[[nodiscard]] ChangeTick getChangeTick() const noexcept
+		{
+			return changeTick_.load(std::memory_order_relaxed);
+		}
+		/**
+		* @brief 差分だけを処理するシステムの開始時に呼び、前回からの変更を拾うためのティックを返します
+		* @param lastRun システムごとに保持する前回実行時のティック。最初は0にしてください
+		* @return Added/Changedフィルタのsinceに渡すティック
+		* @details lastRunを現在のティックに更新し、マネージャーのティックを進めます
+		* - これ以降の変更は次回の呼び出しで拾われます
+		* @code
+		* const auto since = manager.updateChangeTick(lastRun_);
+		* manager.view<Position2D>().each(Changed<Position2D>{ since }, [](Entity& e, Position2D& pos) {});
+		* @endcode
+		*/
+		ChangeTick updateChangeTick(ChangeTick& lastRun) noexcept
+		{
+			const ChangeTick since = lastRun;
+			lastRun = changeTick_.fetch_add(1u, std::memory_order_relaxed);
+			return since;
+		}
+
+		/**
+		* @brief 指定したコンポーネントをすべて持つEntityのビューを返します
+		* @details view<Position2D, Velocity2D>().each([](Entity& e, Position2D& pos, Velocity2D& velocity){});のように使います
+		* - 死んだEntityもrefresh()が呼ばれるまでは走査されます
+		*/
+		template <typename... Ts>[[nodiscard]] View<Ts...> view() const
+		{
+			static_assert(sizeof...(Ts) > 0, "view requires at least one component");
+			return View<Ts...>({ &componentPools_[GetComponentTypeID<Ts>()]... });
+		}
+
+		//!指定したグループに登録されているEntity達を返します
+		[[nodiscard]] std::vector<Entity*>& getEntitiesByGroup(const Group& group)
+		{
+			return groupedEntities_[group];
+		}
+
+		/**
+		* @brief コンポーネントTのメンバfieldの値を過去frameCountフレーム分記録するようにします
+		* @param field 記録するメンバへのポインタ。enableHistory(&Position2D::val, 8)のように指定します
+		* @return ComponentHistory& 記録した値の参照や補間に使います。マネージャーが保持します
+		* @details 同じ型に複数回呼ぶと、メンバごとに別の記録になります
+		*/
+		template <typename T, typename F> ComponentHistory<T, F>& enableHistory(F T::* field, const std::size_t frameCount)
+		{
+			auto pHistory = std::make_unique<ComponentHistory<T, F>>(field, frameCount);
+			auto& history = *pHistory;
+			histories_.emplace_back(GetComponentTypeID<T>(), std::move(pHistory));
+			return history;
+		}
+		/**
+		* @brief enableHistory()した値を新しいフレームとして記録します
+		* @details シミュレーションの1ステップごとに、update()とrefresh()の後で呼びます
+		*/
+		void commitHistory()
+		{
+			for (const auto& it : histories_)
+			{
+				it.second->commit(componentPools_[it.first]);
+			}
+		}
+		/**
+		* @brief enableHistory()した値をframesAgoフレーム前に戻します
+		* @return bool 記録が足りない場合は何もせずfalseを返します
+		* @details 戻したフレームより新しい記録は捨てられ、戻した値は変更として記録されます
+		* - 記録の時点でいなかったEntityの値はそのままです
+		*/
+		bool rollback(const std::size_t framesAgo)
+		{
+			for (const auto& it : histories_)
+			{
+				if (framesAgo >= it.second->size())
+				{
+					return false;
+				}
+			}
+			const ChangeTick tick = getChangeTick();
+			for (const auto& it : histories_)
+			{
+				it.second->restore(componentPools_[it.first], framesAgo, tick);
+			}
+			return true;
+		}
+
+		/**
+		* @brief 条件に一致するEntityを保持し続けるクエリを作ります
+		* @details 作った時点で生きているEntityから結果を作り、以降はrefresh()で差分を反映します
+		* - クエリはマネージャーが保持し、removeQuery()を呼ぶまで有効です
+		*/
+		Query& createQuery(const QueryDesc& desc)
+		{
+			queries_.emplace_back(std::make_unique<Query>(desc));
+			Query& query = *queries_.back();
+			for (const auto& e : entityes_)
+			{
+				query.update(e.get(), e->isActive_ && query.matches(e->componentBitSet_, e->groupBitSet_));
+			}
+			return query;
+		}
+		//!クエリを破棄します
+		void removeQuery(const Query& query)
+		{
+			queries_.erase(std::remove_if(queries_.begin(), queries_.end(),
+				[&query](const std::unique_ptr<Query>& q) { return q.get() == &query; }), queries_.end());
+		}
+
+		//!Entityを指定したグループに登録します
+		void addToGroup(Entity* pEntity, const Group& group)
+		{
+			groupedEntities_[group].emplace_back(pEntity);
+		}
+
+		/**
+		* @brief 共有コンポーネントの値を作ります
+		* @param args Tのコンストラクタと同じものになります
+		* @return Shared<T>& Entity::setShared()やPrefab::setShared()に渡す値
+		* @details 値はマネージャーが保持し、マネージャーが破棄されるまで残ります
+		* - 同じ値を使うEntityには同じShared<T>を渡してください。Entityごとに作ると共有の意味がなくなります
+		*/
+		template <typename T, typename... TArgs>[[nodiscard]] Shared<T>& makeShared(TArgs&&... args)
+		{
+			auto pShared = std::make_unique<Shared<T>>(std::forward<TArgs>(args)...);
+			pShared->typeID_ = GetComponentTypeID<Shared<T>>();
+			passiveComponents_.set(pShared->typeID_);
+			Shared<T>& shared = *pShared;
+			sharedComponents_.emplace_back(std::move(pShared));
+			return shared;
+		}
+
+		/**
+		* @brief 型Tのコンポーネントが追加されたときに呼ぶ関数を登録します
+		* @param func void(const std::vector<Entity*>&)の関数。前回のrefresh()以降に追加されたEntityがまとめて渡されます
+		* @details 通知はrefresh()の中で行われます。EntityPoolでの再利用も追加として通知されます
+		* - 通知の時点でEntityがすでにコンポーネントを外している場合もあります
+		*/
+		template <typename T> void onAdd(std::function<void(const std::vector<Entity*>&)> func)
+		{
+			addObserver(GetComponentTypeID<T>(), &ComponentObserver::onAdd, std::move(func));
+		}
+		/**
+		* @brief 型Tのコンポーネントが削除されたときに呼ぶ関数を登録します
+		* @param func void(const std::vector<Entity*>&)の関数。前回のrefresh()以降に削除したEntityがまとめて渡されます
+		* @details Entityごと削除された場合はこちらではなくonDestroy()で通知されます
+		*/
+		template <typename T> void onRemove(std::function<void(const std::vector<Entity*>&)> func)
+		{
+			addObserver(GetComponentTypeID<T>(), &ComponentObserver::onRemove, std::move(func));
+		}
+		/**
+		* @brief 型Tのコンポーネントを持つEntityが削除されるときに呼ぶ関数を登録します
+		* @param func void(const std::vector<Entity*>&)の関数。このrefresh()で削除されるEntityがまとめて渡されます
+		* @details 通知の時点ではEntityとコンポーネントはまだ残っているので、中身を参照できます
+		* - 通知の中でdestroy()したEntityも同じrefresh()で通知されてから削除されます
+		*/
+		template <typename T> void onDestroy(std::function<void(const std::vector<Entity*>&)> func)
+		{
+			addObserver(GetComponentTypeID<T>(), &ComponentObserver::onDestroy, std::move(func));
+		}
+		/**
+		* @brief 型Tのコンポーネントに登録した関数をすべて解除します
+		* @details 通知の中から呼んだ場合、その型の残りの関数は呼ばれず、解除は通知が終わってから行われます
+		*/
+		template <typename T> void clearObservers()
+		{
+			removeObserver(GetComponentTypeID<T>());
+		}
+
+		/**
+		* @brief 型Eのイベントキューを返します。初めて呼ばれたときに作られます
+		* @details 送られたイベントはrefresh()で読み込み側に移ります。ワーカースレッドから呼んでも安全です
+		* @code
+		* manager.getEvents<HitEvent>().send(HitEvent{ a.getId(), b.getId() });
+		* manager.getEvents<HitEvent>().each([](const HitEvent& e) {});
+		* @endcode
+		*/
+		template <typename E>[[nodiscard]] Events<E>& getEvents()
+		{
+			const std::size_t id = GetEventTypeID<E>();
+			std::lock_guard<std::mutex> lock(eventsMutex_);
+			if (id >= events_.size())
+			{
+				events_.resize(id + 1);
+			}
+			if (events_[id] == nullptr)
+			{
+				events_[id] = std::make_unique<Events<E>>();
+			}
+			return static_cast<Events<E>&>(*events_[id]);
+		}
+
+		/**
+		* @brief Prefabの構成でEntityをcount体まとめて生成します
+		* @param initFunc void(Entity&, std::size_t 何体目か)の関数。座標など個体ごとの値を設定します
+		* @details 最初にEntityとコンポーネントの格納先をcount体分確保してから生成するので、途中で確保し直すことがありません
+		*/
+		template <typename Func> void instantiate(const Prefab& prefab, const std::size_t count, Func&& initFunc)
+		{
+			if (count == 0)
+			{
+				return;
+			}
+			auto& entityPool = BlockPool<Entity>::Get();
+			entityPool.reserve(entityPool.getStats().live + count);
+			entityes_.reserve(entityes_.size() + count);
+			if (count > freeSlots_.size())
+			{
+				slots_.reserve(slots_.size() + count - freeSlots_.size());
+			}
+			for (const auto& recipe : prefab.recipes_)
+			{
+				recipe.reserve(count);
+				componentPools_[recipe.id].reserve(componentPools_[recipe.id].size() + count);
+			}
+			if (prefab.hasGroup_)
+			{
+				groupedEntities_[prefab.group_].reserve(groupedEntities_[prefab.group_].size() + count);
+			}
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				auto& e = createEntity();
+				e.components_.reserve(prefab.recipes_.size());
+				for (const auto& recipe : prefab.recipes_)
+				{
+					recipe.build(e);
+				}
+				if (prefab.hasGroup_)
+				{
+					e.addGroup(prefab.group_);
+				}
+				initFunc(e, i);
+			}
+		}
+		//!Prefabの構成でEntityを1体生成します
+		Entity& instantiate(const Prefab& prefab)
+		{
+			Entity* pEntity = nullptr;
+			instantiate(prefab, 1, [&pEntity](Entity& e, std::size_t) { pEntity = &e; });
+			return *pEntity;
+		}
+		/**
+		* @brief Prefabの構成でEntityを再利用するプールを作ります
+		* @param resetFunc 再利用するEntityを初期状態に戻す関数。不要ならnullptr
+		* @details プールはマネージャーが保持します
+		*/
+		EntityPool& createEntityPool(const Prefab& prefab, std::function<void(Entity&)> resetFunc = nullptr)
+		{
+			entityPools_.emplace_back(std::make_unique<EntityPool>(*this, prefab, std::move(resetFunc)));
+			return *entityPools_.back();
+		}
+
+		/**
+		* @brief Entityを生成しそのポインタを返します。
+		* @return Entity& Entityへの参照
+		* @details 作られたEntityはマネージャーが保持します
+		*/
+		[[nodiscard]] Entity& addEntity()
+		{
+			return createEntity();
+		}
+		/**
+		* @brief Entityを生成しそのポインタを返します。
+		* @param group 属するグループ(size_t)
+		* @return Entity& Entityへの参照
+		* @details 基本的にこちらを使います。作られたEntityはマネージャーが保持します
+		*/
+		[[nodiscard]] Entity& addEntity(const Group& group)
+		{
+			auto& e = createEntity();
+			e.addGroup(group);
+			return e;
+		}
+	};
+
+	inline bool Entity::isProfiling() const noexcept
+	{
+		return manager_.isProfiling_;
+	}
+
+	inline ComponentSystem* Entity::findComponent(const ComponentID id) const noexcept
+	{
+		return manager_.componentPools_[id].get(id_.index);
+	}
+
+	template <typename Func> void EntityPool::spawn(const std::size_t count, Func&& initFunc)
+	{
+		std::size_t i = 0;
+		for (; i < count && !sleeping_.empty(); ++i)
+		{
+			EntityPtr pEntity = std::move(sleeping_.back());
+			sleeping_.pop_back();
+			Entity& e = manager_.reviveEntity(std::move(pEntity));
+			if (resetFunc_)
+			{
+				resetFunc_(e);
+			}
+			initFunc(e, i);
+		}
+		const std::size_t first = i;
+		manager_.instantiate(prefab_, count - first, [&](Entity& e, const std::size_t n)
+		{
+			e.pool_ = this;
+			initFunc(e, first + n);
+		});
+	}
+
+	inline Entity& EntityPool::spawn()
+	{
+		Entity* pEntity = nullptr;
+		spawn(1, [&pEntity](Entity& e, std::size_t) { pEntity = &e; });
+		return *pEntity;
+	}
+
+	inline void EntityPool::prewarm(const std::size_t count)
+	{
+		manager_.instantiate(prefab_, count, [this](Entity& e, std::size_t)
+		{
+			e.pool_ = this;
+			e.destroy();
+		});
+	}
+
+	//以下の処理は必要ないかもしれない//
+
+	//!vectorに格納されているエンティティの更新を行います
 	void EntitiesUpdate(const std::vector<Entity*>& entities);
 	//!vectorに格納されているエンティティの2D描画を行います
 	void EntitiesDraw2D(const std::vector<Entity*>& entities);
 	//!vectorに格納されているエンティティの3D描画を行います
 	void EntitiesDraw3D(const std::vector<Entity*>& entities);
 
-}  //namespace ECS
\ No newline at end of file
+}  //namespace ECS
+
+#pragma pop_macro("new")
\ No newline at end of file
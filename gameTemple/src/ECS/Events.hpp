@@ -0,0 +1,137 @@
+﻿/**
+* @file  Events.hpp
+* @brief 型ごとのイベントをフレーム単位でまとめて受け渡すキューです
+* @author agent
+* @date 2026/10/17
+*/
+#pragma once
+#include <vector>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace ECS
+{
+	//!フレームの切り替わりでイベントを入れ替えるためのインターフェースです
+	class IEvents
+	{
+	public:
+		virtual ~IEvents() = default;
+		//!今のフレームに送られたイベントを読み込み側に移し、書き込み側を空にします
+		virtual void swap() = 0;
+		//!すべてのイベントを破棄します
+		virtual void clear() = 0;
+	};
+
+	/**
+	* @brief 型Eのイベントを送受信するダブルバッファのキューです
+	* @details EntityManager::getEvents<E>()から取得します
+	* - send()したイベントは次のswap()(EntityManager::refresh())の後に、read()やeach()で読めるようになります
+	* - 読めるイベントは前のフレームに送られたものだけで、次のswap()で捨てられます
+	* - send()は複数のスレッドから同時に呼べます。スレッドごとに別の書き込み先を使うので待ちはほとんど発生しません
+	* - swap()とsend()を同時に呼ばないでください
+	*/
+	template <typename E>
+	class Events final : public IEvents
+	{
+	private:
+		static constexpr std::size_t ShardCount = 16;
+		struct alignas(64) Shard
+		{
+			std::mutex mutex;
+			std::vector<E> events;
+		};
+		std::array<Shard, ShardCount> shards_;
+		std::vector<E> readable_;
+
+		//!呼び出したスレッドが書き込む先を返します
+		[[nodiscard]] Shard& getShard() noexcept
+		{
+			static std::atomic<std::size_t> threadCount{ 0 };
+			static thread_local const std::size_t threadIndex = threadCount.fetch_add(1, std::memory_order_relaxed);
+			return shards_[threadIndex % ShardCount];
+		}
+	public:
+		Events() = default;
+		Events(const Events&) = delete;
+		Events& operator=(const Events&) = delete;
+
+		//!イベントを送ります
+		void send(const E& event)
+		{
+			auto& shard = getShard();
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			shard.events.emplace_back(event);
+		}
+		//!イベントを送ります
+		void send(E&& event)
+		{
+			auto& shard = getShard();
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			shard.events.emplace_back(std::move(event));
+		}
+		//!引数からイベントを作って送ります
+		template <typename... TArgs> void emplace(TArgs&&... args)
+		{
+			auto& shard = getShard();
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			shard.events.emplace_back(std::forward<TArgs>(args)...);
+		}
+		/**
+		* @brief 複数のイベントをまとめて送ります
+		* @details ロックは1回しか取らないので、ワーカースレッドでためたイベントを送る場合はこちらを使います
+		*/
+		void sendBatch(const E* events, const std::size_t count)
+		{
+			auto& shard = getShard();
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			shard.events.insert(shard.events.end(), events, events + count);
+		}
+		//!複数のイベントをまとめて送ります
+		void sendBatch(const std::vector<E>& events)
+		{
+			sendBatch(events.data(), events.size());
+		}
+
+		//!前のフレームに送られたイベントを連続した配列で返します
+		[[nodiscard]] const std::vector<E>& read() const noexcept { return readable_; }
+		/**
+		* @brief 前のフレームに送られたイベントを順に渡します
+		* @param func void(const E&)の関数
+		*/
+		template <typename Func> void each(Func&& func) const
+		{
+			for (const auto& it : readable_)
+			{
+				func(it);
+			}
+		}
+		//!読めるイベントの数を返します
+		[[nodiscard]] std::size_t size() const noexcept { return readable_.size(); }
+		//!読めるイベントがないか返します
+		[[nodiscard]] bool empty() const noexcept { return readable_.empty(); }
+
+		void swap() override
+		{
+			readable_.clear();
+			for (auto& shard : shards_)
+			{
+				std::lock_guard<std::mutex> lock(shard.mutex);
+				readable_.insert(readable_.end(),
+					std::make_move_iterator(shard.events.begin()), std::make_move_iterator(shard.events.end()));
+				shard.events.clear();
+			}
+		}
+		void clear() override
+		{
+			readable_.clear();
+			for (auto& shard : shards_)
+			{
+				std::lock_guard<std::mutex> lock(shard.mutex);
+				shard.events.clear();
+			}
+		}
+	};
+}
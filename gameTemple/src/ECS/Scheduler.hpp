@@ -0,0 +1,172 @@
+﻿/**
+* @file  Scheduler.hpp
+* @brief 読み書きするコンポーネントを宣言したシステムを並列に実行します
+* @author agent
+* @date 2026/10/17
+*/
+#pragma once
+#include "ECS.hpp"
+#include "../Utility/ThreadPool.hpp"
+#include <string>
+
+namespace ECS
+{
+	//!システムが読み込むコンポーネントを指定します
+	template <typename... Ts> struct Read final {};
+	//!システムが書き込むコンポーネントを指定します
+	template <typename... Ts> struct Write final {};
+
+	/**
+	* @brief システムの登録と実行を行います
+	* @details 登録されたシステムは読み書きするコンポーネントから依存関係を作り、衝突しないものを並列に実行します
+	* - 同じコンポーネントに書き込む、または一方が書き込み他方が読み込むシステム同士は登録順に実行されます
+	* - システムの中ではEntityやコンポーネントの追加と削除を直接行わず、EntityManager::getCommandBuffer()に記録してください
+	* - 宣言していないコンポーネントに触れた場合の動作は保証されません
+	*/
+	class SystemScheduler final
+	{
+	private:
+		struct System
+		{
+			std::string name;
+			ComponentBitSet reads;
+			ComponentBitSet writes;
+			std::function<void(EntityManager&)> func;
+			std::vector<std::size_t> dependents;
+			std::size_t dependencyCount = 0;
+		};
+		ThreadPool pool_;
+		std::vector<System> systems_;
+		std::unique_ptr<std::atomic<std::size_t>[]> remaining_;
+		bool isDirty_ = true;
+
+		template <template <typename...> class Access, typename... Ts>
+		[[nodiscard]] static ComponentBitSet ToSignature(Access<Ts...>)
+		{
+			ComponentBitSet signature;
+			(signature.set(GetComponentTypeID<Ts>()), ...);
+			return signature;
+		}
+		[[nodiscard]] static bool IsConflict(const System& a, const System& b)
+		{
+			return a.writes.intersects(b.reads | b.writes) || b.writes.intersects(a.reads);
+		}
+		//!システムの依存関係を作り直します
+		void build()
+		{
+			for (auto& it : systems_)
+			{
+				it.dependents.clear();
+				it.dependencyCount = 0;
+			}
+			for (std::size_t j = 0; j < systems_.size(); ++j)
+			{
+				for (std::size_t i = 0; i < j; ++i)
+				{
+					if (IsConflict(systems_[i], systems_[j]))
+					{
+						systems_[i].dependents.emplace_back(j);
+						++systems_[j].dependencyCount;
+					}
+				}
+			}
+			remaining_ = std::make_unique<std::atomic<std::size_t>[]>(systems_.size());
+			isDirty_ = false;
+		}
+		void execute(EntityManager& manager, const std::size_t index, std::atomic<std::size_t>& done)
+		{
+			auto& system = systems_[index];
+			system.func(manager);
+			for (const auto& it : system.dependents)
+			{
+				if (--remaining_[it] == 0)
+				{
+					pool_.submit([this, &manager, &done, it] { execute(manager, it, done); });
+				}
+			}
+			--done;
+		}
+	public:
+		//!ワーカーの数は論理コア数-1になります
+		SystemScheduler() = default;
+		//!ワーカーの数を指定します
+		explicit SystemScheduler(const std::size_t workerCount) :
+			pool_(workerCount)
+		{}
+
+		/**
+		* @brief システムを登録します
+		* @param name システムの名前
+		* @param func void(EntityManager&)の関数
+		* @details テンプレート引数でRead<>とWrite<>を指定してください
+		* - addSystem<Read<Gravity>, Write<Position2D, Velocity2D>>("physics", func);のように使います
+		*/
+		template <typename TRead, typename TWrite, typename Func>
+		void addSystem(const std::string& name, Func&& func)
+		{
+			System system;
+			system.name = name;
+			system.reads = ToSignature(TRead{});
+			system.writes = ToSignature(TWrite{});
+			system.func = std::forward<Func>(func);
+			systems_.emplace_back(std::move(system));
+			isDirty_ = true;
+		}
+
+		//!登録したシステムをすべて削除します
+		void clear()
+		{
+			systems_.clear();
+			isDirty_ = true;
+		}
+
+		/**
+		* @brief 登録したシステムをすべて実行します
+		* @details 依存関係のないシステムから順にスレッドプールへ投げ、すべて終わるまで戻りません
+		*/
+		void run(EntityManager& manager)
+		{
+			if (isDirty_)
+			{
+				build();
+			}
+			if (systems_.empty())
+			{
+				return;
+			}
+			std::atomic<std::size_t> done{ systems_.size() };
+			for (std::size_t i = 0; i < systems_.size(); ++i)
+			{
+				remaining_[i] = systems_[i].dependencyCount;
+			}
+			for (std::size_t i = 0; i < systems_.size(); ++i)
+			{
+				if (systems_[i].dependencyCount == 0)
+				{
+					pool_.submit([this, &manager, &done, i] { execute(manager, i, done); });
+				}
+			}
+			pool_.wait(done);
+		}
+
+		/**
+		* @brief 指定したコンポーネントをすべて持つEntityを分割して並列に処理します
+		* @param func void(Entity&, Ts&...)の関数
+		* @param grain 1つのタスクで処理するEntityの数
+		* @details システムの中から呼ぶことができます。funcは複数のスレッドから同時に呼ばれます
+		*/
+		template <typename... Ts, typename Func>
+		void parallelEach(const EntityManager& manager, Func&& func, const std::size_t grain = 256)
+		{
+			const auto view = manager.view<Ts...>();
+			pool_.parallelFor(0, view.sizeHint(), grain,
+				[&view, &func](const std::size_t begin, const std::size_t end)
+			{
+				view.eachRange(begin, end, func);
+			});
+		}
+
+		//!内部で使っているスレッドプールを返します
+		[[nodiscard]] ThreadPool& getThreadPool() noexcept { return pool_; }
+	};
+}
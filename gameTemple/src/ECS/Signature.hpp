@@ -0,0 +1,287 @@
+﻿/**
+* @file  Signature.hpp
+* @brief コンポーネントやグループの組み合わせを表すビット列です
+* @author agent
+* @date 2026/10/17
+*/
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <assert.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace ECS
+{
+	/**
+	* @brief N個のフラグを持つビット列です
+	* @details std::bitsetとほぼ同じ使い方ができます
+	* - 64bitのワードを32byte境界に並べているので、包含判定や共通部分の判定はSSE2/AVX2でまとめて行います
+	* - SIMDが使えない環境では同じ結果になるスカラーの処理を使います
+	*/
+	template <std::size_t N>
+	class Signature final
+	{
+	private:
+		static constexpr std::size_t WordBits = 64;
+		//!AVX2で1回に扱える4ワード単位に切り上げる
+		static constexpr std::size_t WordCount = ((N + WordBits - 1) / WordBits + 3) / 4 * 4;
+		alignas(32) std::array<std::uint64_t, WordCount> words_{};
+
+		[[nodiscard]] static std::size_t CountTrailingZero(const std::uint64_t word) noexcept
+		{
+#if defined(_MSC_VER) && defined(_M_X64)
+			unsigned long index;
+			_BitScanForward64(&index, word);
+			return index;
+#elif defined(__GNUC__)
+			return static_cast<std::size_t>(__builtin_ctzll(word));
+#else
+			std::size_t index = 0;
+			for (std::uint64_t w = word; (w & 1u) == 0u; w >>= 1)
+			{
+				++index;
+			}
+			return index;
+#endif
+		}
+	public:
+		//!operator[]で書き込むための参照です
+		class reference final
+		{
+		private:
+			friend class Signature;
+			std::uint64_t& word_;
+			std::uint64_t mask_;
+			reference(std::uint64_t& word, const std::size_t bit) noexcept :
+				word_(word),
+				mask_(std::uint64_t(1) << bit)
+			{}
+		public:
+			reference& operator=(const bool value) noexcept
+			{
+				if (value)
+				{
+					word_ |= mask_;
+				}
+				else
+				{
+					word_ &= ~mask_;
+				}
+				return *this;
+			}
+			reference& operator=(const reference& other) noexcept
+			{
+				return *this = static_cast<bool>(other);
+			}
+			operator bool() const noexcept { return (word_ & mask_) != 0u; }
+		};
+
+		//!フラグの数を返します
+		[[nodiscard]] static constexpr std::size_t size() noexcept { return N; }
+
+		[[nodiscard]] bool operator[](const std::size_t pos) const noexcept
+		{
+			return test(pos);
+		}
+		[[nodiscard]] reference operator[](const std::size_t pos) noexcept
+		{
+			assert(pos < N);
+			return reference(words_[pos / WordBits], pos % WordBits);
+		}
+		//!指定した位置のフラグを返します
+		[[nodiscard]] bool test(const std::size_t pos) const noexcept
+		{
+			assert(pos < N);
+			return (words_[pos / WordBits] >> (pos % WordBits) & 1u) != 0u;
+		}
+		//!指定した位置のフラグを設定します
+		Signature& set(const std::size_t pos, const bool value = true) noexcept
+		{
+			(*this)[pos] = value;
+			return *this;
+		}
+		//!すべてのフラグを下ろします
+		Signature& reset() noexcept
+		{
+			words_.fill(0u);
+			return *this;
+		}
+		//!指定した位置のフラグを下ろします
+		Signature& reset(const std::size_t pos) noexcept
+		{
+			return set(pos, false);
+		}
+		//!立っているフラグがあるか返します
+		[[nodiscard]] bool any() const noexcept
+		{
+			for (const auto& w : words_)
+			{
+				if (w != 0u)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+		//!立っているフラグがないか返します
+		[[nodiscard]] bool none() const noexcept { return !any(); }
+		//!立っているフラグの数を返します
+		[[nodiscard]] std::size_t count() const noexcept
+		{
+			std::size_t num = 0;
+			for (auto w : words_)
+			{
+				for (; w != 0u; w &= w - 1)
+				{
+					++num;
+				}
+			}
+			return num;
+		}
+		/**
+		* @brief 立っているフラグの位置を小さい順に渡します
+		* @param func void(std::size_t)の関数
+		* @details 0のワードは読み飛ばすので、フラグが少なければN回のtest()より速く済みます
+		*/
+		template <typename Func> void each(Func&& func) const
+		{
+			for (std::size_t i = 0; i < WordCount; ++i)
+			{
+				for (std::uint64_t w = words_[i]; w != 0u; w &= w - 1)
+				{
+					func(i * WordBits + CountTrailingZero(w));
+				}
+			}
+		}
+
+		/**
+		* @brief requiredのフラグをすべて含んでいるか返します
+		* @details (*this & required) == requiredと同じ結果です
+		*/
+		[[nodiscard]] bool containsAll(const Signature& required) const noexcept
+		{
+#if defined(__AVX2__)
+			__m256i diff = _mm256_setzero_si256();
+			for (std::size_t i = 0; i < WordCount; i += 4)
+			{
+				const __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(&words_[i]));
+				const __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(&required.words_[i]));
+				diff = _mm256_or_si256(diff, _mm256_andnot_si256(a, b));
+			}
+			return _mm256_testz_si256(diff, diff) != 0;
+#elif defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+			__m128i diff = _mm_setzero_si128();
+			for (std::size_t i = 0; i < WordCount; i += 2)
+			{
+				const __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(&words_[i]));
+				const __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(&required.words_[i]));
+				diff = _mm_or_si128(diff, _mm_andnot_si128(a, b));
+			}
+			return _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) == 0xFFFF;
+#else
+			std::uint64_t diff = 0u;
+			for (std::size_t i = 0; i < WordCount; ++i)
+			{
+				diff |= ~words_[i] & required.words_[i];
+			}
+			return diff == 0u;
+#endif
+		}
+		//!otherと共通するフラグがあるか返します
+		[[nodiscard]] bool intersects(const Signature& other) const noexcept
+		{
+#if defined(__AVX2__)
+			__m256i common = _mm256_setzero_si256();
+			for (std::size_t i = 0; i < WordCount; i += 4)
+			{
+				const __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(&words_[i]));
+				const __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(&other.words_[i]));
+				common = _mm256_or_si256(common, _mm256_and_si256(a, b));
+			}
+			return _mm256_testz_si256(common, common) == 0;
+#elif defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+			__m128i common = _mm_setzero_si128();
+			for (std::size_t i = 0; i < WordCount; i += 2)
+			{
+				const __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(&words_[i]));
+				const __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(&other.words_[i]));
+				common = _mm_or_si128(common, _mm_and_si128(a, b));
+			}
+			return _mm_movemask_epi8(_mm_cmpeq_epi8(common, _mm_setzero_si128())) != 0xFFFF;
+#else
+			std::uint64_t common = 0u;
+			for (std::size_t i = 0; i < WordCount; ++i)
+			{
+				common |= words_[i] & other.words_[i];
+			}
+			return common != 0u;
+#endif
+		}
+
+		Signature& operator&=(const Signature& other) noexcept
+		{
+			for (std::size_t i = 0; i < WordCount; ++i)
+			{
+				words_[i] &= other.words_[i];
+			}
+			return *this;
+		}
+		Signature& operator|=(const Signature& other) noexcept
+		{
+			for (std::size_t i = 0; i < WordCount; ++i)
+			{
+				words_[i] |= other.words_[i];
+			}
+			return *this;
+		}
+		[[nodiscard]] friend Signature operator&(const Signature& a, const Signature& b) noexcept
+		{
+			Signature result = a;
+			return result &= b;
+		}
+		[[nodiscard]] friend Signature operator|(const Signature& a, const Signature& b) noexcept
+		{
+			Signature result = a;
+			return result |= b;
+		}
+		[[nodiscard]] bool operator==(const Signature& other) const noexcept
+		{
+			return words_ == other.words_;
+		}
+		[[nodiscard]] bool operator!=(const Signature& other) const noexcept
+		{
+			return !(*this == other);
+		}
+		//!ハッシュ値を返します
+		[[nodiscard]] std::size_t hash() const noexcept
+		{
+			std::uint64_t h = 14695981039346656037ull;
+			for (const auto& w : words_)
+			{
+				h = (h ^ w) * 1099511628211ull;
+			}
+			return static_cast<std::size_t>(h);
+		}
+	};
+}
+
+namespace std
+{
+	template <std::size_t N>
+	struct hash<ECS::Signature<N>>
+	{
+		std::size_t operator()(const ECS::Signature<N>& signature) const noexcept
+		{
+			return signature.hash();
+		}
+	};
+}
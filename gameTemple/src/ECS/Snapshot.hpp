@@ -0,0 +1,619 @@
+﻿/**
+* @file  Snapshot.hpp
+* @brief EntityManagerの状態をバイナリで保存、復元します
+* @author agent
+* @date 2026/10/17
+*/
+#pragma once
+#include "ECS.hpp"
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <type_traits>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace ECS
+{
+	/**
+	* @brief 読み込み専用でメモリにマップしたファイルです
+	* @details ファイルの内容はコピーされず、アクセスしたページだけがOSによって読み込まれます
+	*/
+	class MappedFile final
+	{
+	private:
+#if defined(_WIN32)
+		HANDLE file_ = INVALID_HANDLE_VALUE;
+		HANDLE mapping_ = nullptr;
+#else
+		int file_ = -1;
+#endif
+		const std::uint8_t* data_ = nullptr;
+		std::size_t size_ = 0;
+	public:
+		explicit MappedFile(const std::string& path)
+		{
+#if defined(_WIN32)
+			file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			LARGE_INTEGER size;
+			if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &size) || size.QuadPart == 0)
+			{
+				return;
+			}
+			mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping_ == nullptr)
+			{
+				return;
+			}
+			data_ = static_cast<const std::uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+			size_ = data_ != nullptr ? static_cast<std::size_t>(size.QuadPart) : 0;
+#else
+			file_ = open(path.c_str(), O_RDONLY);
+			struct stat st;
+			if (file_ < 0 || fstat(file_, &st) != 0 || st.st_size == 0)
+			{
+				return;
+			}
+			void* p = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, file_, 0);
+			if (p == MAP_FAILED)
+			{
+				return;
+			}
+			data_ = static_cast<const std::uint8_t*>(p);
+			size_ = static_cast<std::size_t>(st.st_size);
+#endif
+		}
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile()
+		{
+#if defined(_WIN32)
+			if (data_ != nullptr) UnmapViewOfFile(data_);
+			if (mapping_ != nullptr) CloseHandle(mapping_);
+			if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+#else
+			if (data_ != nullptr) munmap(const_cast<std::uint8_t*>(data_), size_);
+			if (file_ >= 0) close(file_);
+#endif
+		}
+		//!マップできたか返します
+		[[nodiscard]] bool isOpen() const noexcept { return data_ != nullptr; }
+		[[nodiscard]] const std::uint8_t* data() const noexcept { return data_; }
+		[[nodiscard]] std::size_t size() const noexcept { return size_; }
+	};
+
+	//!スナップショットでEntityを指す番号がないことを表す値
+	constexpr std::uint32_t SnapshotNone = static_cast<std::uint32_t>(-1);
+
+	/**
+	* @brief スナップショットへ値を書き込みます
+	* @details Snapshot::addComponent()に渡す保存関数で使います
+	*/
+	class SnapshotWriter final
+	{
+	private:
+		std::vector<std::uint8_t>& buffer_;
+		const EntityManager& manager_;
+		const std::vector<std::uint32_t>& ordinals_;
+	public:
+		SnapshotWriter(std::vector<std::uint8_t>& buffer, const EntityManager& manager, const std::vector<std::uint32_t>& ordinals) :
+			buffer_(buffer),
+			manager_(manager),
+			ordinals_(ordinals)
+		{}
+		/**
+		* @brief 末尾にsizeバイトの領域を確保し、その先頭を返します
+		* @details 返したポインタは次に書き込むまで有効です。まとめて書き込む場合に使います
+		*/
+		[[nodiscard]] std::uint8_t* allocate(const std::size_t size)
+		{
+			const std::size_t offset = buffer_.size();
+			buffer_.resize(offset + size);
+			return buffer_.data() + offset;
+		}
+		//!sizeバイトをそのまま書き込みます
+		void write(const void* data, const std::size_t size)
+		{
+			std::memcpy(allocate(size), data, size);
+		}
+		//!値をそのまま書き込みます。Tはmemcpyできる型にしてください
+		template <typename T> void write(const T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+			write(&value, sizeof(T));
+		}
+		//!文字列を書き込みます
+		void writeString(const std::string& str)
+		{
+			write(static_cast<std::uint32_t>(str.size()));
+			write(str.data(), str.size());
+		}
+		/**
+		* @brief Entityのハンドルを書き込みます
+		* @details 読み込み時にSnapshotReader::readEntity()で新しいハンドルに置き換えられます
+		* - 無効なハンドルや保存されないEntityは無効なハンドルとして読み込まれます
+		*/
+		void writeEntity(const EntityId& id)
+		{
+			const bool isSaved = manager_.isValid(id) && id.index < ordinals_.size();
+			write(isSaved ? ordinals_[id.index] : SnapshotNone);
+		}
+		//!バッファの現在のバイト数を返します
+		[[nodiscard]] std::size_t size() const noexcept { return buffer_.size(); }
+		//!バッファの指定位置に値を上書きします
+		template <typename T> void overwrite(const std::size_t offset, const T& value)
+		{
+			std::memcpy(buffer_.data() + offset, &value, sizeof(T));
+		}
+	};
+
+	/**
+	* @brief スナップショットから値を読み込みます
+	* @details 範囲外を読もうとした場合は失敗状態になり、以降は0を返します
+	*/
+	class SnapshotReader final
+	{
+	private:
+		const std::uint8_t* current_;
+		const std::uint8_t* end_;
+		const std::vector<EntityId>& entities_;
+		bool isFailed_ = false;
+	public:
+		SnapshotReader(const std::uint8_t* begin, const std::uint8_t* end, const std::vector<EntityId>& entities) :
+			current_(begin),
+			end_(end),
+			entities_(entities)
+		{}
+		//!sizeバイトを読み込みます。失敗した場合はfalseを返します
+		bool read(void* dst, const std::size_t size)
+		{
+			if (isFailed_ || static_cast<std::size_t>(end_ - current_) < size)
+			{
+				isFailed_ = true;
+				std::memset(dst, 0, size);
+				return false;
+			}
+			std::memcpy(dst, current_, size);
+			current_ += size;
+			return true;
+		}
+		//!値を読み込みます
+		template <typename T>[[nodiscard]] T read()
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+			T value;
+			read(&value, sizeof(T));
+			return value;
+		}
+		//!文字列を読み込みます
+		[[nodiscard]] std::string readString()
+		{
+			const auto size = read<std::uint32_t>();
+			if (isFailed_ || static_cast<std::size_t>(end_ - current_) < size)
+			{
+				isFailed_ = true;
+				return {};
+			}
+			std::string str(reinterpret_cast<const char*>(current_), size);
+			current_ += size;
+			return str;
+		}
+		//!SnapshotWriter::writeEntity()で書き込んだハンドルを、読み込んだEntityのハンドルに置き換えて返します
+		[[nodiscard]] EntityId readEntity()
+		{
+			const auto ordinal = read<std::uint32_t>();
+			return ordinal < entities_.size() ? entities_[ordinal] : EntityId{};
+		}
+		//!読み込んでいない部分を指すポインタを返し、sizeバイト進めます。足りなければnullptrを返します
+		[[nodiscard]] const std::uint8_t* skip(const std::size_t size)
+		{
+			if (isFailed_ || static_cast<std::size_t>(end_ - current_) < size)
+			{
+				isFailed_ = true;
+				return nullptr;
+			}
+			const std::uint8_t* p = current_;
+			current_ += size;
+			return p;
+		}
+		//!範囲外を読もうとしたか返します
+		[[nodiscard]] bool isFailed() const noexcept { return isFailed_; }
+	};
+
+	//!Snapshot::load()の結果です
+	struct SnapshotLoadResult final
+	{
+		/**
+		* @brief 読み込みに成功したか
+		* @details 検証で失敗した場合はEntityを1つも作りません。
+		* 独自の読み込み関数で失敗した場合は作ったEntityをdestroy()するので、次のrefresh()で取り除かれます
+		*/
+		bool isSucceeded = false;
+		//!登録されていない型や、メンバの構成が変わった型のため読み込まなかったセクションの型ハッシュ
+		std::vector<std::uint64_t> skippedTypes;
+		explicit operator bool() const noexcept { return isSucceeded; }
+		//!すべてのセクションを読み込めたか返します
+		[[nodiscard]] bool isComplete() const noexcept { return isSucceeded && skippedTypes.empty(); }
+	};
+
+	/**
+	* @brief EntityManagerの状態をバイナリで保存、復元するための設定です
+	* @details 保存するコンポーネントの型を登録してからsave()やload()を呼びます
+	* - 保存されるのは生きているEntity、そのグループ、登録した型のコンポーネントとタグです
+	* - コンポーネントは型ごとにまとめて保存します。メンバを指定した型はメンバごとに全Entity分を連続して書き出すので、
+	*   読み込みはメンバごとのmemcpyだけで済みます
+	* - 型はGetComponentTypeHash()で識別するので、登録していない型や知らない型のデータは読み飛ばし、SnapshotLoadResult::skippedTypesで報告します
+	* - 読み込んだEntityは既存のEntityに追加されます。シーンを置き換える場合は先にremoveAll()とrefresh()を呼んでください
+	* - 共有コンポーネントとEntityPoolで眠っているEntityは保存されません
+	* - load(path)はファイルをメモリにマップしますが、データをそのまま使うのではなく、Entityを作ってコンポーネントを追加し直します。
+	*   コンポーネントはEntityごとにBlockPoolから確保されるので、ポインタを書き換えてその場で使う形式にはしていません
+	*/
+	class Snapshot final
+	{
+	private:
+		static constexpr std::uint32_t Magic = 0x53534345u;	//"ECSS"
+		static constexpr std::uint32_t Version = 1u;
+		enum class Kind : std::uint32_t
+		{
+			FIELDS,
+			CUSTOM,
+			TAG,
+		};
+		struct Header
+		{
+			std::uint32_t magic;
+			std::uint32_t version;
+			std::uint32_t groupBytes;
+			std::uint32_t entityCount;
+			std::uint32_t sectionCount;
+		};
+		struct SectionHeader
+		{
+			std::uint64_t hash;
+			Kind kind;
+			std::uint32_t count;
+			std::uint64_t bytes;
+		};
+		struct TypeEntry
+		{
+			std::uint64_t hash;
+			ComponentID id;
+			Kind kind;
+			//!dense番目までのEntityのうち保存するもののデータを書き込みます
+			std::function<void(SnapshotWriter&, const ComponentPool&, const std::vector<std::uint32_t>& dense)> save;
+			//!保存したときと構成が同じか調べます。違えばセクションは読み飛ばします
+			std::function<bool(SnapshotReader&)> matches;
+			//!各Entityにコンポーネントを追加し、データを読み込みます
+			std::function<void(SnapshotReader&, const std::vector<Entity*>&)> load;
+		};
+		std::vector<TypeEntry> types_;
+
+		[[nodiscard]] const TypeEntry* findType(const std::uint64_t hash) const noexcept
+		{
+			for (const auto& it : types_)
+			{
+				if (it.hash == hash)
+				{
+					return &it;
+				}
+			}
+			return nullptr;
+		}
+		/**
+		* @brief Entityを作る前に、すべてのセクションが範囲内に収まり、通し番号が正しいか調べます
+		* @details readerの位置は変えません
+		*/
+		[[nodiscard]] static bool validateSections(const SnapshotReader& reader, const Header& header)
+		{
+			SnapshotReader sections = reader;
+			for (std::uint32_t s = 0; s < header.sectionCount; ++s)
+			{
+				const auto section = sections.read<SectionHeader>();
+				const std::uint8_t* body = sections.skip(static_cast<std::size_t>(section.bytes));
+				if (static_cast<std::size_t>(section.bytes) != section.bytes || body == nullptr ||
+					section.bytes < sizeof(std::uint32_t) * static_cast<std::uint64_t>(section.count))
+				{
+					return false;
+				}
+				for (std::uint32_t i = 0; i < section.count; ++i)
+				{
+					std::uint32_t ordinal;
+					std::memcpy(&ordinal, body + sizeof(std::uint32_t) * i, sizeof(std::uint32_t));
+					if (ordinal >= header.entityCount)
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+		template <typename T, typename F> static void WriteColumn(SnapshotWriter& writer, const ComponentPool& pool, const std::vector<std::uint32_t>& dense, F T::* field)
+		{
+			const auto& components = pool.getComponents();
+			std::uint8_t* dst = writer.allocate(sizeof(F) * dense.size());
+			for (const auto& i : dense)
+			{
+				std::memcpy(dst, &(static_cast<const T*>(components[i])->*field), sizeof(F));
+				dst += sizeof(F);
+			}
+		}
+		template <typename T, typename F> static void ReadColumn(SnapshotReader& reader, const std::vector<T*>& components, F T::* field)
+		{
+			const std::uint8_t* src = reader.skip(sizeof(F) * components.size());
+			if (src == nullptr)
+			{
+				return;
+			}
+			for (const auto& c : components)
+			{
+				std::memcpy(&(c->*field), src, sizeof(F));
+				src += sizeof(F);
+			}
+		}
+	public:
+		/**
+		* @brief 指定したメンバを保存するコンポーネントを登録します
+		* @param fields 保存するメンバへのポインタ。memcpyできる型である必要があります
+		* @details addComponent<Position2D>(&Position2D::val);のように使います
+		* - 読み込み時はデフォルトコンストラクタでaddComponent()した後、メンバを上書きします。initialize()は上書きの前に呼ばれます
+		* - コンポーネントの初期化で他のコンポーネントを参照する場合は、参照される型を先に登録してください
+		*/
+		template <typename T, typename... Fs> Snapshot& addComponent(Fs T::*... fields)
+		{
+			static_assert((std::is_trivially_copyable_v<Fs> && ...), "fields must be trivially copyable");
+			static_assert(std::is_default_constructible_v<T>, "T must be default constructible");
+			TypeEntry entry;
+			entry.hash = GetComponentTypeHash<T>();
+			entry.id = GetComponentTypeID<T>();
+			entry.kind = Kind::FIELDS;
+			entry.save = [fields...](SnapshotWriter& writer, const ComponentPool& pool, const std::vector<std::uint32_t>& dense)
+			{
+				const std::uint32_t sizes[] = { 0u, static_cast<std::uint32_t>(sizeof(Fs))... };
+				writer.write(static_cast<std::uint32_t>(sizeof...(Fs)));
+				writer.write(sizes + 1, sizeof(std::uint32_t) * sizeof...(Fs));
+				(WriteColumn(writer, pool, dense, fields), ...);
+			};
+			entry.matches = [](SnapshotReader& reader)
+			{
+				const std::uint32_t sizes[] = { 0u, static_cast<std::uint32_t>(sizeof(Fs))... };
+				std::uint32_t saved[sizeof...(Fs) + 1] = {};
+				return reader.read<std::uint32_t>() == sizeof...(Fs) &&
+					reader.read(saved + 1, sizeof(std::uint32_t) * sizeof...(Fs)) &&
+					std::memcmp(sizes, saved, sizeof(sizes)) == 0;
+			};
+			entry.load = [fields...](SnapshotReader& reader, const std::vector<Entity*>& entities)
+			{
+				std::vector<T*> components;
+				components.reserve(entities.size());
+				BlockPool<T>::Get().reserve(BlockPool<T>::Get().getStats().live + entities.size());
+				for (const auto& e : entities)
+				{
+					components.emplace_back(&e->addComponent<T>());
+				}
+				(ReadColumn(reader, components, fields), ...);
+			};
+			types_.emplace_back(std::move(entry));
+			return *this;
+		}
+		/**
+		* @brief 保存と読み込みの関数を指定してコンポーネントを登録します
+		* @param saveFunc void(SnapshotWriter&, const T&)の関数
+		* @param loadFunc void(SnapshotReader&, Entity&)の関数。コンポーネントの追加もこの関数で行います
+		* @details メンバに文字列やEntityのハンドルを持つ型に使います
+		*/
+		template <typename T> Snapshot& addComponent(std::function<void(SnapshotWriter&, const T&)> saveFunc,
+			std::function<void(SnapshotReader&, Entity&)> loadFunc)
+		{
+			TypeEntry entry;
+			entry.hash = GetComponentTypeHash<T>();
+			entry.id = GetComponentTypeID<T>();
+			entry.kind = Kind::CUSTOM;
+			entry.matches = [](SnapshotReader&) { return true; };
+			entry.save = [saveFunc = std::move(saveFunc)](SnapshotWriter& writer, const ComponentPool& pool, const std::vector<std::uint32_t>& dense)
+			{
+				const auto& components = pool.getComponents();
+				for (const auto& i : dense)
+				{
+					saveFunc(writer, *static_cast<const T*>(components[i]));
+				}
+			};
+			entry.load = [loadFunc = std::move(loadFunc)](SnapshotReader& reader, const std::vector<Entity*>& entities)
+			{
+				for (const auto& e : entities)
+				{
+					loadFunc(reader, *e);
+				}
+			};
+			types_.emplace_back(std::move(entry));
+			return *this;
+		}
+		//!保存するタグを登録します
+		template <typename T> Snapshot& addTag()
+		{
+			TypeEntry entry;
+			entry.hash = GetComponentTypeHash<T>();
+			entry.id = GetComponentTypeID<T>();
+			entry.kind = Kind::TAG;
+			entry.matches = [](SnapshotReader&) { return true; };
+			entry.save = [](SnapshotWriter&, const ComponentPool&, const std::vector<std::uint32_t>&) {};
+			entry.load = [](SnapshotReader&, const std::vector<Entity*>& entities)
+			{
+				for (const auto& e : entities)
+				{
+					e->addTag<T>();
+				}
+			};
+			types_.emplace_back(std::move(entry));
+			return *this;
+		}
+
+		//!マネージャーの状態をバイト列に書き出します
+		[[nodiscard]] std::vector<std::uint8_t> save(const EntityManager& manager) const
+		{
+			std::vector<std::uint8_t> buffer;
+			//Entityの番号から保存時の通し番号を引く表
+			std::vector<std::uint32_t> ordinals(manager.slots_.size(), SnapshotNone);
+			std::vector<const Entity*> entities;
+			entities.reserve(manager.entityes_.size());
+			for (const auto& e : manager.entityes_)
+			{
+				if (e->isActive_)
+				{
+					ordinals[e->id_.index] = static_cast<std::uint32_t>(entities.size());
+					entities.emplace_back(e.get());
+				}
+			}
+			SnapshotWriter writer(buffer, manager, ordinals);
+			const Header header = { Magic, Version, static_cast<std::uint32_t>(sizeof(GroupBitSet)),
+				static_cast<std::uint32_t>(entities.size()), static_cast<std::uint32_t>(types_.size()) };
+			buffer.reserve(sizeof(Header) + sizeof(GroupBitSet) * entities.size());
+			writer.write(header);
+			std::uint8_t* groups = writer.allocate(sizeof(GroupBitSet) * entities.size());
+			for (const auto& e : entities)
+			{
+				std::memcpy(groups, &e->groupBitSet_, sizeof(GroupBitSet));
+				groups += sizeof(GroupBitSet);
+			}
+			std::vector<std::uint32_t> dense;
+			for (const auto& type : types_)
+			{
+				const auto& pool = manager.componentPools_[type.id];
+				dense.clear();
+				for (std::size_t i = 0; i < pool.size(); ++i)
+				{
+					if (pool.getEntities()[i]->isActive_)
+					{
+						dense.emplace_back(static_cast<std::uint32_t>(i));
+					}
+				}
+				const std::size_t headerOffset = writer.size();
+				writer.write(SectionHeader{ type.hash, type.kind, static_cast<std::uint32_t>(dense.size()), 0u });
+				const std::size_t bodyOffset = writer.size();
+				std::uint8_t* dst = writer.allocate(sizeof(std::uint32_t) * dense.size());
+				for (const auto& i : dense)
+				{
+					std::memcpy(dst, &ordinals[pool.getEntities()[i]->id_.index], sizeof(std::uint32_t));
+					dst += sizeof(std::uint32_t);
+				}
+				type.save(writer, pool, dense);
+				writer.overwrite(headerOffset + offsetof(SectionHeader, bytes), static_cast<std::uint64_t>(writer.size() - bodyOffset));
+			}
+			return buffer;
+		}
+		//!マネージャーの状態をファイルに書き出します
+		bool save(const EntityManager& manager, const std::string& path) const
+		{
+			const auto buffer = save(manager);
+			std::ofstream ofs(path, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!ofs)
+			{
+				return false;
+			}
+			ofs.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+			return static_cast<bool>(ofs);
+		}
+
+		/**
+		* @brief バイト列からEntityを復元し、マネージャーに追加します
+		* @return SnapshotLoadResult 形式が正しくない場合は失敗になります
+		* @details セクションの範囲とEntityの通し番号は、Entityを作る前にすべて検証します。ここで失敗した場合はマネージャーは変わりません
+		* - 独自の読み込み関数が範囲外を読んだ場合は、それまでに作ったEntityをdestroy()して失敗を返します。
+		*   Entityは次のrefresh()まで死んだ状態でマネージャーに残り、追加と削除のオブザーバーもそれらのEntityに対して呼ばれます
+		* - 読み飛ばしたセクションは失敗にはならず、skippedTypesで報告します
+		*/
+		SnapshotLoadResult load(EntityManager& manager, const std::uint8_t* data, const std::size_t size) const
+		{
+			SnapshotLoadResult result;
+			std::vector<EntityId> ids;
+			SnapshotReader reader(data, data + size, ids);
+			const auto header = reader.read<Header>();
+			if (reader.isFailed() || header.magic != Magic || header.version != Version || header.groupBytes != sizeof(GroupBitSet))
+			{
+				return result;
+			}
+			const std::uint8_t* groups = reader.skip(sizeof(GroupBitSet) * header.entityCount);
+			if (groups == nullptr || !validateSections(reader, header))
+			{
+				return result;
+			}
+			std::vector<Entity*> entities;
+			entities.reserve(header.entityCount);
+			ids.reserve(header.entityCount);
+			auto& entityPool = BlockPool<Entity>::Get();
+			entityPool.reserve(entityPool.getStats().live + header.entityCount);
+			manager.entityes_.reserve(manager.entityes_.size() + header.entityCount);
+			for (std::uint32_t i = 0; i < header.entityCount; ++i)
+			{
+				auto& e = manager.createEntity();
+				GroupBitSet groupBitSet;
+				std::memcpy(&groupBitSet, groups + sizeof(GroupBitSet) * i, sizeof(GroupBitSet));
+				groupBitSet.each([&e](const std::size_t group) { e.addGroup(group); });
+				entities.emplace_back(&e);
+				ids.emplace_back(e.getId());
+			}
+			std::vector<Entity*> targets;
+			for (std::uint32_t s = 0; s < header.sectionCount; ++s)
+			{
+				//範囲と通し番号は検証済み
+				const auto section = reader.read<SectionHeader>();
+				const std::uint8_t* body = reader.skip(static_cast<std::size_t>(section.bytes));
+				const TypeEntry* type = findType(section.hash);
+				if (type == nullptr || type->kind != section.kind)
+				{
+					result.skippedTypes.emplace_back(section.hash);
+					continue;
+				}
+				SnapshotReader sectionReader(body, body + section.bytes, ids);
+				targets.clear();
+				targets.reserve(section.count);
+				for (std::uint32_t i = 0; i < section.count; ++i)
+				{
+					targets.emplace_back(entities[sectionReader.read<std::uint32_t>()]);
+				}
+				if (!type->matches(sectionReader))
+				{
+					//メンバの構成が変わっている
+					result.skippedTypes.emplace_back(section.hash);
+					continue;
+				}
+				type->load(sectionReader, targets);
+				if (sectionReader.isFailed())
+				{
+					for (const auto& e : entities)
+					{
+						e->destroy();
+					}
+					result.skippedTypes.clear();
+					return result;
+				}
+			}
+			result.isSucceeded = true;
+			return result;
+		}
+		//!バイト列からEntityを復元し、マネージャーに追加します
+		SnapshotLoadResult load(EntityManager& manager, const std::vector<std::uint8_t>& data) const
+		{
+			return load(manager, data.data(), data.size());
+		}
+		//!ファイルをメモリにマップしてEntityを復元し、マネージャーに追加します
+		SnapshotLoadResult load(EntityManager& manager, const std::string& path) const
+		{
+			const MappedFile file(path);
+			if (!file.isOpen())
+			{
+				return SnapshotLoadResult{};
+			}
+			return load(manager, file.data(), file.size());
+		}
+	};
+}
@@ -0,0 +1,349 @@
+﻿/**
+* @file  TransformHierarchy.hpp
+* @brief Transform2Dの親子関係をまとめて管理し、ワールド行列を計算します
+* @author agent
+* @date 2026/10/17
+*/
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <assert.h>
+#include "../Utility/Vec.hpp"
+#include "../Utility/Math.hpp"
+
+namespace ECS
+{
+	class Entity;
+
+	/**
+	* @brief 2x3のアフィン変換行列です
+	* @details (x, y)は(a * x + c * y + tx, b * x + d * y + ty)に変換されます
+	*/
+	struct Matrix2x3 final
+	{
+		float a = 1.f, b = 0.f;
+		float c = 0.f, d = 1.f;
+		float tx = 0.f, ty = 0.f;
+
+		//!拡大、回転(度数法)、平行移動の順に適用する行列を作ります
+		[[nodiscard]] static Matrix2x3 Make(const Vec2& pos, const float rotation, const Vec2& scale) noexcept
+		{
+			const float rad = Math::ToRadian(rotation);
+			const float cs = cosf(rad);
+			const float sn = sinf(rad);
+			Matrix2x3 m;
+			m.a = cs * scale.x;
+			m.b = sn * scale.x;
+			m.c = -sn * scale.y;
+			m.d = cs * scale.y;
+			m.tx = pos.x;
+			m.ty = pos.y;
+			return m;
+		}
+		//!行列の積を返します。otherを先に適用します
+		[[nodiscard]] Matrix2x3 operator*(const Matrix2x3& other) const noexcept
+		{
+			Matrix2x3 m;
+			m.a = a * other.a + c * other.b;
+			m.b = b * other.a + d * other.b;
+			m.c = a * other.c + c * other.d;
+			m.d = b * other.c + d * other.d;
+			m.tx = a * other.tx + c * other.ty + tx;
+			m.ty = b * other.tx + d * other.ty + ty;
+			return m;
+		}
+		//!座標を変換します
+		[[nodiscard]] Vec2 transformPoint(const Vec2& p) const noexcept
+		{
+			return Vec2(a * p.x + c * p.y + tx, b * p.x + d * p.y + ty);
+		}
+		//!逆行列を返します。逆行列が存在しない場合は単位行列を返します
+		[[nodiscard]] Matrix2x3 inverse() const noexcept
+		{
+			const float det = a * d - b * c;
+			if (det == 0.f)
+			{
+				return Matrix2x3{};
+			}
+			const float inv = 1.f / det;
+			Matrix2x3 m;
+			m.a = d * inv;
+			m.b = -b * inv;
+			m.c = -c * inv;
+			m.d = a * inv;
+			m.tx = (c * ty - d * tx) * inv;
+			m.ty = (b * tx - a * ty) * inv;
+			return m;
+		}
+	};
+
+	/**
+	* @brief Transform2Dの親子関係を連続した配列で管理します
+	* @details ノードは常に親が子より前に並ぶように保たれるので、先頭から1回走査するだけで親の変更が子に伝わります
+	* - 相対値が変わったノードとその子孫だけワールド行列を計算し直します。動かない階層のコストは走査だけです
+	* - 親のないノードは結び付けたPosition2D等の値を相対値として読み、子を持つ場合だけ変化を調べます
+	* - 子のノードは計算したワールド座標、回転、拡大率を結び付けたPosition2D等に書き込みます
+	* - ワールドの回転は親と子の回転の和、拡大率は積です。回転した親の非一様な拡大で生じるせん断は回転と拡大率には表れません
+	* - EntityManager::update()の最後に呼ばれます
+	*/
+	class TransformHierarchy final
+	{
+	public:
+		using Handle = std::uint32_t;
+		static constexpr Handle NONE = static_cast<Handle>(-1);
+
+		//!ノードが読み書きするコンポーネントの値です
+		struct Binding
+		{
+			Entity* entity;
+			Vec2* position;
+			float* rotation;
+			Vec2* scale;
+			std::size_t positionID;
+			std::size_t rotationID;
+			std::size_t scaleID;
+		};
+	private:
+		struct Local
+		{
+			Vec2 position;
+			float rotation = 0.f;
+			Vec2 scale{ 1.f, 1.f };
+		};
+		enum Flag : std::uint8_t
+		{
+			LOCAL_DIRTY = 1 << 0,
+			WORLD_UPDATED = 1 << 1,
+			DEAD = 1 << 2,
+		};
+		static constexpr std::uint32_t NO_INDEX = static_cast<std::uint32_t>(-1);
+
+		//以下は並び順を揃えた密な配列
+		std::vector<Handle> handles_;
+		std::vector<std::uint32_t> parents_;
+		std::vector<std::uint32_t> childCounts_;
+		std::vector<std::uint8_t> flags_;
+		std::vector<Local> locals_;
+		std::vector<Matrix2x3> localMatrices_;
+		std::vector<Matrix2x3> worlds_;
+		std::vector<float> worldRotations_;
+		std::vector<Vec2> worldScales_;
+		std::vector<Binding> bindings_;
+
+		std::vector<std::uint32_t> indexOf_;
+		std::vector<Handle> freeHandles_;
+		std::size_t deadCount_ = 0;
+		std::size_t linkCount_ = 0;
+		bool isOrderDirty_ = false;
+
+		//!ノードの現在のワールド行列を親をたどって計算します
+		[[nodiscard]] Matrix2x3 calcWorld(const std::uint32_t index, float& rotation, Vec2& scale) const
+		{
+			if (parents_[index] == NO_INDEX)
+			{
+				const auto& bind = bindings_[index];
+				rotation = *bind.rotation;
+				scale = *bind.scale;
+				return Matrix2x3::Make(*bind.position, *bind.rotation, *bind.scale);
+			}
+			const auto& local = locals_[index];
+			const Matrix2x3 parent = calcWorld(parents_[index], rotation, scale);
+			rotation += local.rotation;
+			scale.x *= local.scale.x;
+			scale.y *= local.scale.y;
+			return parent * Matrix2x3::Make(local.position, local.rotation, local.scale);
+		}
+		//!死んだノードを詰め、親が子より前に来るように並べ直します
+		void rebuild();
+		//!dense番目のノードを並び順を崩さずに消します
+		void erase(const std::uint32_t index)
+		{
+			flags_[index] |= DEAD;
+			++deadCount_;
+			if (parents_[index] != NO_INDEX)
+			{
+				--childCounts_[parents_[index]];
+				--linkCount_;
+				parents_[index] = NO_INDEX;
+			}
+			if (childCounts_[index] > 0)
+			{
+				//子は親のいないノードになり、最後のワールド座標をそのまま保つ
+				for (std::uint32_t i = 0; i < parents_.size(); ++i)
+				{
+					if (parents_[i] == index)
+					{
+						parents_[i] = NO_INDEX;
+						--linkCount_;
+					}
+				}
+				childCounts_[index] = 0;
+			}
+			if (deadCount_ * 2 > handles_.size())
+			{
+				isOrderDirty_ = true;
+			}
+		}
+	public:
+		TransformHierarchy() = default;
+		TransformHierarchy(const TransformHierarchy&) = delete;
+		TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+		//!ノードを親のない状態で追加し、ハンドルを返します
+		[[nodiscard]] Handle add(const Binding& binding)
+		{
+			Handle handle;
+			if (freeHandles_.empty())
+			{
+				handle = static_cast<Handle>(indexOf_.size());
+				indexOf_.emplace_back(NO_INDEX);
+			}
+			else
+			{
+				handle = freeHandles_.back();
+				freeHandles_.pop_back();
+			}
+			indexOf_[handle] = static_cast<std::uint32_t>(handles_.size());
+			handles_.emplace_back(handle);
+			parents_.emplace_back(NO_INDEX);
+			childCounts_.emplace_back(0u);
+			flags_.emplace_back(std::uint8_t(0));
+			Local local;
+			local.position = *binding.position;
+			local.rotation = *binding.rotation;
+			local.scale = *binding.scale;
+			locals_.emplace_back(local);
+			localMatrices_.emplace_back();
+			worlds_.emplace_back();
+			worldRotations_.emplace_back(0.f);
+			worldScales_.emplace_back(1.f, 1.f);
+			bindings_.emplace_back(binding);
+			return handle;
+		}
+		//!ノードを削除します。子は親のないノードになります
+		void remove(const Handle handle)
+		{
+			if (handle >= indexOf_.size() || indexOf_[handle] == NO_INDEX)
+			{
+				return;
+			}
+			erase(indexOf_[handle]);
+			indexOf_[handle] = NO_INDEX;
+			freeHandles_.emplace_back(handle);
+		}
+		/**
+		* @brief 親を設定します
+		* @param parent 親のハンドル。NONEを指定すると親子関係を解除します
+		* @return 親子関係が循環する場合はfalseを返し、何もしません
+		* @details 現在のワールド座標が変わらないように相対値を計算します
+		*/
+		bool setParent(const Handle child, const Handle parent)
+		{
+			const std::uint32_t index = indexOf_[child];
+			const std::uint32_t parentIndex = parent == NONE ? NO_INDEX : indexOf_[parent];
+			for (std::uint32_t it = parentIndex; it != NO_INDEX; it = parents_[it])
+			{
+				if (it == index)
+				{
+					return false;
+				}
+			}
+			float rotation;
+			Vec2 scale;
+			const Vec2 position = calcWorld(index, rotation, scale).transformPoint(Vec2(0.f, 0.f));
+			if (parents_[index] != NO_INDEX)
+			{
+				--childCounts_[parents_[index]];
+				--linkCount_;
+			}
+			parents_[index] = parentIndex;
+			auto& local = locals_[index];
+			if (parentIndex == NO_INDEX)
+			{
+				local.position = position;
+				local.rotation = rotation;
+				local.scale = scale;
+				return true;
+			}
+			float parentRotation;
+			Vec2 parentScale;
+			const Matrix2x3 parentWorld = calcWorld(parentIndex, parentRotation, parentScale);
+			local.position = parentWorld.inverse().transformPoint(position);
+			local.rotation = rotation - parentRotation;
+			local.scale.x = parentScale.x != 0.f ? scale.x / parentScale.x : scale.x;
+			local.scale.y = parentScale.y != 0.f ? scale.y / parentScale.y : scale.y;
+			flags_[index] |= LOCAL_DIRTY;
+			//親の行列は子を持つまで計算していないので、次の更新で計算させる
+			flags_[parentIndex] |= LOCAL_DIRTY;
+			++childCounts_[parentIndex];
+			++linkCount_;
+			if (parentIndex > index)
+			{
+				isOrderDirty_ = true;
+			}
+			return true;
+		}
+		//!親のハンドルを返します。親がいない場合はNONEが返ります
+		[[nodiscard]] Handle getParent(const Handle handle) const noexcept
+		{
+			const std::uint32_t parent = parents_[indexOf_[handle]];
+			return parent == NO_INDEX ? NONE : handles_[parent];
+		}
+		//!ノードに結び付けたEntityを返します
+		[[nodiscard]] Entity* getEntity(const Handle handle) const noexcept
+		{
+			return bindings_[indexOf_[handle]].entity;
+		}
+		//!親に対する相対座標を返します
+		[[nodiscard]] const Vec2& getLocalPosition(const Handle handle) const noexcept { return locals_[indexOf_[handle]].position; }
+		//!親に対する相対回転率を返します
+		[[nodiscard]] float getLocalRotation(const Handle handle) const noexcept { return locals_[indexOf_[handle]].rotation; }
+		//!親に対する相対拡大率を返します
+		[[nodiscard]] const Vec2& getLocalScale(const Handle handle) const noexcept { return locals_[indexOf_[handle]].scale; }
+		//!親に対する相対座標を設定します
+		void setLocalPosition(const Handle handle, const Vec2& position) noexcept
+		{
+			const std::uint32_t index = indexOf_[handle];
+			locals_[index].position = position;
+			flags_[index] |= LOCAL_DIRTY;
+		}
+		//!親に対する相対回転率を設定します
+		void setLocalRotation(const Handle handle, const float rotation) noexcept
+		{
+			const std::uint32_t index = indexOf_[handle];
+			locals_[index].rotation = rotation;
+			flags_[index] |= LOCAL_DIRTY;
+		}
+		//!親に対する相対拡大率を設定します
+		void setLocalScale(const Handle handle, const Vec2& scale) noexcept
+		{
+			const std::uint32_t index = indexOf_[handle];
+			locals_[index].scale = scale;
+			flags_[index] |= LOCAL_DIRTY;
+		}
+		/**
+		* @brief 最後のupdate()で計算したワールド行列を返します
+		* @details 親子関係を持たないノードは計算していないので、その場で計算します
+		*/
+		[[nodiscard]] Matrix2x3 getWorldMatrix(const Handle handle) const
+		{
+			const std::uint32_t index = indexOf_[handle];
+			if (parents_[index] == NO_INDEX && childCounts_[index] == 0)
+			{
+				float rotation;
+				Vec2 scale;
+				return calcWorld(index, rotation, scale);
+			}
+			return worlds_[index];
+		}
+		//!登録されているノードの数を返します
+		[[nodiscard]] std::size_t size() const noexcept { return handles_.size() - deadCount_; }
+
+		/**
+		* @brief 変更のあったノードとその子孫のワールド行列を計算し、結び付けたコンポーネントに書き込みます
+		* @details 親子関係が1つもなければ何もしません
+		*/
+		void update();
+	};
+}
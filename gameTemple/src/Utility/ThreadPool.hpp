@@ -0,0 +1,230 @@
+﻿/**
+* @file ThreadPool.hpp
+* @brief ワークスティーリングを行うスレッドプールです
+* @author agent
+* @date 2026/10/17
+*/
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+
+/*! @class ThreadPool
+*   @brief ワーカーごとにタスクのキューを持ち、空いたワーカーは他のキューからタスクを盗んで実行します
+*   @details 自分のキューは後ろから、他のキューは前から取り出します
+*   - 待機中のスレッド(メインスレッドを含む)もwait()の中でタスクを実行するので、タスクの中からさらにタスクを投げても詰まりません
+*   - ワーカー数が0の場合はwait()を呼んだスレッドがすべて実行します
+*/
+class ThreadPool final
+{
+private:
+	using Task = std::function<void()>;
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+	static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+	//0番はワーカー以外のスレッドが使うキュー
+	std::vector<std::unique_ptr<Queue>> queues_;
+	std::vector<std::thread> threads_;
+	std::mutex sleepMutex_;
+	std::condition_variable cv_;
+	//!wait()で眠っているスレッドを起こす
+	std::condition_variable waitCv_;
+	std::atomic<std::size_t> pending_{ 0 };
+	std::atomic<std::size_t> waiting_{ 0 };
+	bool isStop_ = false;
+
+	//!現在のスレッドが使うキューの番号です
+	static std::size_t& CurrentIndex()
+	{
+		static thread_local std::size_t index = NONE;
+		return index;
+	}
+	[[nodiscard]] std::size_t currentQueue() const
+	{
+		const auto index = CurrentIndex();
+		return index < queues_.size() ? index : 0;
+	}
+	[[nodiscard]] bool pop(const std::size_t self, Task& task)
+	{
+		{
+			auto& own = *queues_[self];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.tasks.empty())
+			{
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				return true;
+			}
+		}
+		for (std::size_t i = 1; i < queues_.size(); ++i)
+		{
+			auto& other = *queues_[(self + i) % queues_.size()];
+			std::lock_guard<std::mutex> lock(other.mutex);
+			if (!other.tasks.empty())
+			{
+				task = std::move(other.tasks.front());
+				other.tasks.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+	//!wait()で眠っているスレッドがいれば、カウンターを調べ直させます
+	void notifyWaiting()
+	{
+		if (waiting_ == 0)
+		{
+			return;
+		}
+		{
+			//眠る直前のスレッドが条件を調べ終わるまで待ってから起こす
+			std::lock_guard<std::mutex> lock(sleepMutex_);
+		}
+		waitCv_.notify_all();
+	}
+	void workerLoop(const std::size_t index)
+	{
+		CurrentIndex() = index;
+		for (;;)
+		{
+			if (tryRunOne())
+			{
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(sleepMutex_);
+			cv_.wait(lock, [this] { return isStop_ || pending_ > 0; });
+			if (isStop_ && pending_ == 0)
+			{
+				return;
+			}
+		}
+	}
+public:
+	//!ワーカーの数を指定します。省略した場合は論理コア数-1です
+	explicit ThreadPool(const std::size_t workerCount = (std::max)(std::thread::hardware_concurrency(), 1u) - 1)
+	{
+		for (std::size_t i = 0; i < workerCount + 1; ++i)
+		{
+			queues_.emplace_back(std::make_unique<Queue>());
+		}
+		for (std::size_t i = 1; i <= workerCount; ++i)
+		{
+			threads_.emplace_back([this, i] { workerLoop(i); });
+		}
+	}
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex_);
+			isStop_ = true;
+		}
+		cv_.notify_all();
+		for (auto& it : threads_)
+		{
+			it.join();
+		}
+	}
+
+	//!ワーカースレッドの数を返します
+	[[nodiscard]] std::size_t getWorkerCount() const noexcept { return threads_.size(); }
+
+	//!タスクを追加します。呼び出したスレッドのキューに積まれます
+	void submit(Task task)
+	{
+		//キューに積む前に数えておかないと、先に盗まれて実行されたときにpending_が0を下回る
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex_);
+			++pending_;
+		}
+		{
+			auto& queue = *queues_[currentQueue()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.emplace_back(std::move(task));
+		}
+		cv_.notify_one();
+		if (waiting_ > 0)
+		{
+			waitCv_.notify_all();
+		}
+	}
+
+	//!キューからタスクを1つ取り出して実行します。実行できるタスクがなければfalseを返します
+	bool tryRunOne()
+	{
+		Task task;
+		if (!pop(currentQueue(), task))
+		{
+			return false;
+		}
+		--pending_;
+		task();
+		notifyWaiting();
+		return true;
+	}
+
+	/**
+	* @brief カウンターが0になるまで、タスクを実行しながら待ちます
+	* @details 盗めるタスクがなくなったら、タスクが終わるか追加されるまで眠ります
+	* - カウンターはこのプールで実行するタスクの中で減らしてください
+	*/
+	void wait(const std::atomic<std::size_t>& counter)
+	{
+		while (counter.load() > 0)
+		{
+			if (tryRunOne())
+			{
+				continue;
+			}
+			++waiting_;
+			{
+				std::unique_lock<std::mutex> lock(sleepMutex_);
+				waitCv_.wait(lock, [&] { return counter.load() == 0 || pending_ > 0; });
+			}
+			--waiting_;
+		}
+	}
+
+	/**
+	* @brief [begin, end)をgrain個ずつに分けて並列に処理します
+	* @param func void(std::size_t begin, std::size_t end)の関数
+	* @details すべての処理が終わるまで戻りません
+	*/
+	template <typename Func> void parallelFor(const std::size_t begin, const std::size_t end, const std::size_t grain, Func&& func)
+	{
+		if (begin >= end)
+		{
+			return;
+		}
+		const std::size_t step = std::max<std::size_t>(grain, 1);
+		if (end - begin <= step || threads_.empty())
+		{
+			func(begin, end);
+			return;
+		}
+		std::atomic<std::size_t> counter{ (end - begin + step - 1) / step };
+		for (std::size_t first = begin + step; first < end; first += step)
+		{
+			const std::size_t last = (std::min)(first + step, end);
+			submit([&func, &counter, first, last]
+			{
+				func(first, last);
+				--counter;
+			});
+		}
+		//最初の区間は呼び出したスレッドで処理する
+		func(begin, (std::min)(begin + step, end));
+		--counter;
+		wait(counter);
+	}
+};
@@ -11,6 +11,8 @@
 - 2018/10/07 tonarinohito
 -# TVecからVecTにリネーム
 -# テンプレートコンストラクタ追加
+- 2026/10/17 agent
+-# コピーとデストラクタをdefaultにしてmemcpyできる型にした
 */
 #pragma once
 
@@ -37,12 +39,8 @@ public:
 		x = setX;
 		y = setY;
 	};
-	Vec2T(const Vec2T& v)
-	{
-		x = v.x;
-		y = v.y;
-	}
-	~Vec2T() {};
+	Vec2T(const Vec2T& v) = default;
+	~Vec2T() = default;
 	/*!
 	* @brief オフセット値を返します
 	* @return Vec2
@@ -231,12 +229,7 @@ public:
 		return ret;
 	}
 
-	Vec2T& operator=(const Vec2T & v)
-	{
-		x = v.x;
-		y = v.y;
-		return *this;
-	}
+	Vec2T& operator=(const Vec2T & v) = default;
 
 	Vec2T& operator=(const T & v)
 	{
@@ -348,14 +341,9 @@ public:
 		y = setY;
 		z = setZ;
 	}
-	Vec3T(const Vec3T& v)
-	{
-		x = v.x;
-		y = v.y;
-		z = v.z;
-	}
+	Vec3T(const Vec3T& v) = default;
 
-	~Vec3T() {};
+	~Vec3T() = default;
 	/*!
 	* @brief オフセット値を返します
 	* @return Vec3
@@ -535,13 +523,7 @@ public:
 				    (v.z - z) * (v.z - z));
 	}
 
-	Vec3T& operator=(const  Vec3T & v)
-	{
-		x = v.x;
-		y = v.y;
-		z = v.z;
-		return *this;
-	}
+	Vec3T& operator=(const  Vec3T & v) = default;
 
 	Vec3T& operator=(const  T & v)
 	{
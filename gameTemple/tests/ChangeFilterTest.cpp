@@ -0,0 +1,152 @@
+﻿#include "Test.hpp"
+#include "ECS/ECS.hpp"
+
+using namespace ECS;
+
+struct Position final : ComponentData
+{
+	int x = 0;
+};
+
+struct Velocity final : ComponentData
+{
+	int x = 1;
+};
+
+//!フィルタを通ったEntityのIDを集めます
+template <typename Filter, typename... Ts>
+std::vector<EntityId> Collect(EntityManager& manager, const Filter& filter)
+{
+	std::vector<EntityId> ids;
+	manager.view<Ts...>().each(filter, [&](Entity& e, Ts&...) { ids.emplace_back(e.getId()); });
+	return ids;
+}
+
+TEST_CASE(FirstRunSeesEverything)
+{
+	EntityManager manager;
+	for (int i = 0; i < 10; ++i)
+	{
+		manager.addEntity().addComponent<Position>();
+	}
+	ChangeTick lastRun = 0u;
+	const ChangeTick since = manager.updateChangeTick(lastRun);
+	CHECK(since == 0u);
+	CHECK(lastRun != 0u);
+	CHECK((Collect<Added<Position>, Position>(manager, Added<Position>{ since }).size() == 10u));
+	CHECK((Collect<Changed<Position>, Position>(manager, Changed<Position>{ since }).size() == 10u));
+}
+
+TEST_CASE(NothingChangedSeesNothing)
+{
+	EntityManager manager;
+	for (int i = 0; i < 10; ++i)
+	{
+		manager.addEntity().addComponent<Position>();
+	}
+	ChangeTick lastRun = 0u;
+	(void)manager.updateChangeTick(lastRun);
+	manager.update();
+	manager.refresh();
+	const ChangeTick since = manager.updateChangeTick(lastRun);
+	CHECK((Collect<Added<Position>, Position>(manager, Added<Position>{ since }).empty()));
+	CHECK((Collect<Changed<Position>, Position>(manager, Changed<Position>{ since }).empty()));
+}
+
+TEST_CASE(ChangedSeesOnlyMarkedComponents)
+{
+	EntityManager manager;
+	std::vector<Entity*> entities;
+	for (int i = 0; i < 10; ++i)
+	{
+		auto& e = manager.addEntity();
+		e.addComponent<Position>();
+		e.addComponent<Velocity>();
+		entities.emplace_back(&e);
+	}
+	ChangeTick lastRun = 0u;
+	(void)manager.updateChangeTick(lastRun);
+
+	entities[2]->getComponent<Position>().x = 5;
+	entities[2]->markChanged<Position>();
+	entities[7]->markChanged<Position>();
+	//別の型の変更は拾わない
+	entities[4]->markChanged<Velocity>();
+	//持っていない型のmarkChanged()は何もしない
+	manager.addEntity().markChanged<Position>();
+
+	const ChangeTick since = manager.updateChangeTick(lastRun);
+	const auto changed = Collect<Changed<Position>, Position>(manager, Changed<Position>{ since });
+	CHECK(changed.size() == 2u);
+	CHECK(std::find(changed.begin(), changed.end(), entities[2]->getId()) != changed.end());
+	CHECK(std::find(changed.begin(), changed.end(), entities[7]->getId()) != changed.end());
+	//変更は追加ではない
+	CHECK((Collect<Added<Position>, Position>(manager, Added<Position>{ since }).empty()));
+	//複数の型のビューでもフィルタの型だけを見る
+	CHECK((Collect<Changed<Velocity>, Position, Velocity>(manager, Changed<Velocity>{ since }).size() == 1u));
+
+	//拾った変更は次の実行では見えない
+	const ChangeTick next = manager.updateChangeTick(lastRun);
+	CHECK((Collect<Changed<Position>, Position>(manager, Changed<Position>{ next }).empty()));
+}
+
+TEST_CASE(AddedSeesNewComponents)
+{
+	EntityManager manager;
+	auto& old = manager.addEntity();
+	old.addComponent<Position>();
+	ChangeTick lastRun = 0u;
+	(void)manager.updateChangeTick(lastRun);
+
+	auto& fresh = manager.addEntity();
+	fresh.addComponent<Position>();
+	//既存のEntityに後から追加した場合も拾う
+	auto& late = manager.addEntity();
+	manager.refresh();
+	late.addComponent<Position>();
+
+	const ChangeTick since = manager.updateChangeTick(lastRun);
+	const auto added = Collect<Added<Position>, Position>(manager, Added<Position>{ since });
+	CHECK(added.size() == 2u);
+	CHECK(std::find(added.begin(), added.end(), old.getId()) == added.end());
+	//追加は変更にも含まれる
+	CHECK((Collect<Changed<Position>, Position>(manager, Changed<Position>{ since }).size() == 2u));
+}
+
+TEST_CASE(ReAddedComponentCountsAsAdded)
+{
+	EntityManager manager;
+	auto& e = manager.addEntity();
+	e.addComponent<Position>();
+	ChangeTick lastRun = 0u;
+	(void)manager.updateChangeTick(lastRun);
+
+	e.removeComponent<Position>();
+	manager.refresh();
+	e.addComponent<Position>();
+	const ChangeTick since = manager.updateChangeTick(lastRun);
+	CHECK((Collect<Added<Position>, Position>(manager, Added<Position>{ since }).size() == 1u));
+}
+
+TEST_CASE(IndependentSystemsKeepTheirOwnTicks)
+{
+	EntityManager manager;
+	auto& e = manager.addEntity();
+	e.addComponent<Position>();
+	ChangeTick systemA = 0u;
+	ChangeTick systemB = 0u;
+	(void)manager.updateChangeTick(systemA);
+	(void)manager.updateChangeTick(systemB);
+
+	e.markChanged<Position>();
+	const ChangeTick sinceA = manager.updateChangeTick(systemA);
+	CHECK((Collect<Changed<Position>, Position>(manager, Changed<Position>{ sinceA }).size() == 1u));
+	//Aが拾った後でもBはまだ拾える
+	const ChangeTick sinceB = manager.updateChangeTick(systemB);
+	CHECK((Collect<Changed<Position>, Position>(manager, Changed<Position>{ sinceB }).size() == 1u));
+}
+
+int main()
+{
+	return Test::RunAll();
+}
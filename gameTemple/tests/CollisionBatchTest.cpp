@@ -0,0 +1,231 @@
+﻿#include "Test.hpp"
+#include "ECS/ECS.hpp"
+#include "Collision/Collision.hpp"
+#include "Collision/CollisionBatch.hpp"
+#include <limits>
+
+using namespace ECS;
+
+namespace
+{
+	//!境界やNaNを混ぜた値を返す乱数です
+	class Values final
+	{
+	private:
+		std::uint32_t seed_;
+	public:
+		explicit Values(const std::uint32_t seed) : seed_(seed) {}
+		std::uint32_t next()
+		{
+			seed_ = seed_ * 1103515245u + 12345u;
+			return seed_ >> 8;
+		}
+		//!-20から80の範囲の値をおおむね返し、時々特殊な値を返します
+		float get()
+		{
+			static const float special[] = {
+				0.f, -0.f, 1.f, -1.f, 10.f, 1e-7f, 1e30f, -1e30f,
+				std::numeric_limits<float>::infinity(),
+				-std::numeric_limits<float>::infinity(),
+				std::numeric_limits<float>::quiet_NaN(),
+				std::numeric_limits<float>::denorm_min(),
+			};
+			if (next() % 16u == 0u)
+			{
+				return special[next() % (sizeof(special) / sizeof(special[0]))];
+			}
+			//同じ値が出やすいように格子に丸める
+			if (next() % 4u == 0u)
+			{
+				return static_cast<float>(next() % 20u) * 5.f;
+			}
+			return static_cast<float>(next() % 100000u) / 1000.f - 20.f;
+		}
+		Vec2 vec() { return Vec2(get(), get()); }
+	};
+
+	//!SIMDの幅の倍数と余りの両方を通るペア数です
+	const std::size_t Counts[] = { 0u, 1u, 3u, 4u, 7u, 8u, 9u, 63u, 64u, 65u, 1000u, 4099u };
+}
+
+TEST_CASE(BoxAndBoxMatchesScalar)
+{
+	Values values(1u);
+	for (const auto count : Counts)
+	{
+		Collision2DBatch::BoxPairs pairs;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const Vec2 pos = values.vec();
+			//接しているだけのペアを混ぜる
+			if (i % 5 == 0)
+			{
+				const Vec2 size(10.f, 10.f);
+				pairs.add(pos, size, Vec2(pos.x + size.x, pos.y), size);
+				continue;
+			}
+			pairs.add(pos, values.vec(), values.vec(), values.vec());
+		}
+		Collision2DBatch::HitMask hits;
+		Collision2DBatch::BoxAndBox(pairs, hits);
+		CHECK(hits.size() == count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const bool expected = Collision2D::BoxAndBox(Vec2(pairs.x1[i], pairs.y1[i]), Vec2(pairs.w1[i], pairs.h1[i]),
+				Vec2(pairs.x2[i], pairs.y2[i]), Vec2(pairs.w2[i], pairs.h2[i]));
+			CHECK(hits.test(i) == expected);
+		}
+	}
+}
+
+TEST_CASE(CircleAndCircleMatchesScalar)
+{
+	Values values(2u);
+	for (const auto count : Counts)
+	{
+		Collision2DBatch::CirclePairs pairs;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const Vec2 pos = values.vec();
+			//ちょうど接している円を混ぜる
+			if (i % 5 == 0)
+			{
+				pairs.add(pos, 3.f, Vec2(pos.x + 7.f, pos.y), 4.f);
+				continue;
+			}
+			pairs.add(pos, values.get(), values.vec(), values.get());
+		}
+		Collision2DBatch::HitMask hits;
+		Collision2DBatch::CircleAndCircle(pairs, hits);
+		CHECK(hits.size() == count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const bool expected = Collision2D::CircleAndCircle(Vec2(pairs.x1[i], pairs.y1[i]), pairs.r1[i],
+				Vec2(pairs.x2[i], pairs.y2[i]), pairs.r2[i]);
+			CHECK(hits.test(i) == expected);
+		}
+	}
+}
+
+TEST_CASE(CircleAndBoxMatchesScalar)
+{
+	Values values(3u);
+	for (const auto count : Counts)
+	{
+		Collision2DBatch::CircleBoxPairs pairs;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const Vec2 pos = values.vec();
+			if (i % 5 == 0)
+			{
+				pairs.add(pos, 5.f, Vec2(pos.x + 5.f, pos.y), Vec2(10.f, 10.f));
+				continue;
+			}
+			pairs.add(pos, values.get(), values.vec(), values.vec());
+		}
+		Collision2DBatch::HitMask hits;
+		Collision2DBatch::CircleAndBox(pairs, hits);
+		CHECK(hits.size() == count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const bool expected = Collision2D::CircleAndBox(Vec2(pairs.cx[i], pairs.cy[i]), pairs.r[i],
+				Vec2(pairs.bx[i], pairs.by[i]), Vec2(pairs.bw[i], pairs.bh[i]));
+			CHECK(hits.test(i) == expected);
+		}
+	}
+}
+
+TEST_CASE(LineAndLineMatchesScalar)
+{
+	Values values(4u);
+	for (const auto count : Counts)
+	{
+		Collision2DBatch::LinePairs pairs;
+		std::vector<LineData2D> l1s, l2s;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const LineData2D l1(values.vec(), values.vec());
+			LineData2D l2(values.vec(), values.vec());
+			//同じ線分、端点を共有する線分、同一直線上の線分を混ぜる
+			switch (i % 7)
+			{
+			case 0: l2 = l1; break;
+			case 1: l2 = LineData2D(l1.p2, values.vec()); break;
+			case 2: l2 = LineData2D(l1.p1 + (l1.p2 - l1.p1) * 2.f, l1.p2 + (l1.p2 - l1.p1) * 2.f); break;
+			default: break;
+			}
+			pairs.add(l1, l2);
+			l1s.emplace_back(l1);
+			l2s.emplace_back(l2);
+		}
+		Collision2DBatch::HitMask hits;
+		Collision2DBatch::LineAndLine(pairs, hits);
+		CHECK(hits.size() == count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			CHECK(hits.test(i) == Collision2D::LineAndLine(l1s[i], l2s[i]));
+		}
+	}
+}
+
+TEST_CASE(ResultDoesNotDependOnLane)
+{
+	//先頭に1組足して、同じペアをSIMDのレーンと余りの両方で判定させる
+	Values values(5u);
+	Collision2DBatch::BoxPairs pairs, shifted;
+	shifted.add(Vec2(0.f, 0.f), Vec2(1.f, 1.f), Vec2(0.5f, 0.5f), Vec2(1.f, 1.f));
+	for (std::size_t i = 0; i < 257; ++i)
+	{
+		const Vec2 p1 = values.vec(), s1 = values.vec(), p2 = values.vec(), s2 = values.vec();
+		pairs.add(p1, s1, p2, s2);
+		shifted.add(p1, s1, p2, s2);
+	}
+	Collision2DBatch::HitMask hits, shiftedHits;
+	Collision2DBatch::BoxAndBox(pairs, hits);
+	Collision2DBatch::BoxAndBox(shifted, shiftedHits);
+	CHECK(shiftedHits.test(0));
+	for (std::size_t i = 0; i < pairs.size(); ++i)
+	{
+		CHECK(hits.test(i) == shiftedHits.test(i + 1));
+	}
+}
+
+TEST_CASE(HitMaskEachAndCount)
+{
+	Values values(6u);
+	Collision2DBatch::CirclePairs pairs;
+	for (std::size_t i = 0; i < 1000; ++i)
+	{
+		pairs.add(values.vec(), values.get(), values.vec(), values.get());
+	}
+	Collision2DBatch::HitMask hits;
+	Collision2DBatch::CircleAndCircle(pairs, hits);
+	std::size_t expected = 0;
+	for (std::size_t i = 0; i < hits.size(); ++i)
+	{
+		expected += hits.test(i) ? 1u : 0u;
+	}
+	CHECK(hits.count() == expected);
+	std::size_t visited = 0;
+	std::size_t last = 0;
+	hits.each([&](const std::size_t i)
+	{
+		CHECK(hits.test(i));
+		CHECK(visited == 0u || i > last);
+		last = i;
+		++visited;
+	});
+	CHECK(visited == expected);
+
+	//再利用しても前の結果は残らない
+	pairs.clear();
+	Collision2DBatch::CircleAndCircle(pairs, hits);
+	CHECK(hits.size() == 0u);
+	CHECK(hits.count() == 0u);
+}
+
+int main()
+{
+	std::cout << "lane width " << Collision2DBatch::LANE_WIDTH << std::endl;
+	return Test::RunAll();
+}
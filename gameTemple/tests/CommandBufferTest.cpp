@@ -0,0 +1,211 @@
+﻿#include "Test.hpp"
+#include "ECS/ECS.hpp"
+#include <thread>
+
+using namespace ECS;
+
+struct Value final : ComponentData
+{
+	int value;
+	explicit Value(const int v) : value(v) {}
+};
+
+struct Other final : ComponentData {};
+
+//!initialize()が呼ばれた順番を記録します
+struct Tracer final : ComponentSystem
+{
+	std::vector<int>* log;
+	int tag;
+	Tracer(std::vector<int>* l, const int t) : log(l), tag(t) {}
+	void initialize() override { log->emplace_back(tag); }
+};
+
+//!update()の中からEntityの生成と自身の削除を記録します
+struct Spawner final : ComponentSystem
+{
+	void update() override
+	{
+		auto& commands = owner->getManager().getCommandBuffer();
+		commands.createEntity([](Entity& e) { e.addComponent<Value>(7); });
+		commands.destroyEntity(owner->getId());
+	}
+};
+
+TEST_CASE(CommandsRunOnRefresh)
+{
+	EntityManager manager;
+	auto& e = manager.addEntity();
+	auto& commands = manager.getCommandBuffer();
+	commands.addComponent<Value>(e.getId(), 1);
+	CHECK(commands.size() == 1u);
+	CHECK(!e.hasComponent<Value>());
+	manager.refresh();
+	CHECK(commands.size() == 0u);
+	CHECK(e.hasComponent<Value>());
+	CHECK(e.getComponent<Value>().value == 1);
+}
+
+TEST_CASE(SameEntityKeepsRecordedOrder)
+{
+	EntityManager manager;
+	auto& e = manager.addEntity();
+	const EntityId id = e.getId();
+	auto& commands = manager.getCommandBuffer();
+	commands.addComponent<Value>(id, 1);
+	commands.addComponent<Other>(id);
+	commands.removeComponent<Value>(id);
+	commands.removeComponent<Other>(id);
+	commands.addComponent<Value>(id, 2);
+	manager.refresh();
+	CHECK(e.hasComponent<Value>());
+	CHECK(e.getComponent<Value>().value == 2);
+	CHECK(!e.hasComponent<Other>());
+}
+
+TEST_CASE(InterleavedEntitiesKeepRecordedOrder)
+{
+	EntityManager manager;
+	auto& a = manager.addEntity();
+	auto& b = manager.addEntity();
+	auto& commands = manager.getCommandBuffer();
+	//別のEntityへの記録が混ざっても、Entityごとの順番は保たれる
+	commands.addComponent<Value>(b.getId(), 10);
+	commands.addComponent<Value>(a.getId(), 1);
+	commands.removeComponent<Value>(a.getId());
+	commands.removeComponent<Value>(b.getId());
+	commands.addComponent<Value>(b.getId(), 11);
+	manager.refresh();
+	CHECK(!a.hasComponent<Value>());
+	CHECK(b.hasComponent<Value>());
+	CHECK(b.getComponent<Value>().value == 11);
+}
+
+TEST_CASE(CreateRunsBeforeDestroy)
+{
+	EntityManager manager;
+	auto& e = manager.addEntity();
+	const EntityId id = e.getId();
+	auto& commands = manager.getCommandBuffer();
+	//削除を先に記録しても、コンポーネントの追加が先に実行される
+	commands.destroyEntity(id);
+	commands.addComponent<Value>(id, 3);
+	bool created = false;
+	commands.createEntity([&](Entity& entity)
+	{
+		created = true;
+		//この時点ではまだ削除されていない
+		CHECK(manager.isValid(id));
+		entity.addComponent<Value>(4);
+	});
+	std::size_t hasValue = 0;
+	manager.refresh();
+	CHECK(created);
+	CHECK(!manager.isValid(id));
+	manager.view<Value>().each([&](Entity&, Value& v)
+	{
+		CHECK(v.value == 4);
+		++hasValue;
+	});
+	CHECK(hasValue == 1u);
+}
+
+TEST_CASE(DestroyRunsAfterModify)
+{
+	EntityManager manager;
+	std::vector<int> log;
+	auto& e = manager.addEntity();
+	const EntityId id = e.getId();
+	auto& commands = manager.getCommandBuffer();
+	commands.destroyEntity(id);
+	commands.addComponent<Tracer>(id, &log, 1);
+	manager.refresh();
+	//追加は削除の前に実行されるので、initialize()は呼ばれている
+	CHECK(log.size() == 1u);
+	CHECK(!manager.isValid(id));
+}
+
+TEST_CASE(StaleIdIsIgnored)
+{
+	EntityManager manager;
+	auto& e = manager.addEntity();
+	const EntityId oldId = e.getId();
+	e.destroy();
+	manager.refresh();
+	auto& reused = manager.addEntity();
+	CHECK(reused.getId().index == oldId.index);
+
+	auto& commands = manager.getCommandBuffer();
+	commands.addComponent<Value>(oldId, 5);
+	commands.destroyEntity(oldId);
+	manager.refresh();
+	CHECK(manager.isValid(reused.getId()));
+	CHECK(!reused.hasComponent<Value>());
+}
+
+TEST_CASE(CommandsRecordedInUpdate)
+{
+	EntityManager manager;
+	auto& spawner = manager.addEntity();
+	spawner.addComponent<Spawner>();
+	const EntityId id = spawner.getId();
+	manager.update();
+	CHECK(manager.isValid(id));
+	CHECK(manager.getCommandBuffer().size() == 2u);
+	manager.refresh();
+	CHECK(!manager.isValid(id));
+	std::size_t count = 0;
+	manager.view<Value>().each([&](Entity&, Value& v)
+	{
+		CHECK(v.value == 7);
+		++count;
+	});
+	CHECK(count == 1u);
+}
+
+TEST_CASE(RecordFromWorkerThreads)
+{
+	EntityManager manager;
+	std::vector<EntityId> ids;
+	for (int i = 0; i < 100; ++i)
+	{
+		ids.emplace_back(manager.addEntity().getId());
+	}
+	auto& commands = manager.getCommandBuffer();
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([&, t]()
+		{
+			for (int i = t; i < 100; i += 4)
+			{
+				commands.addComponent<Value>(ids[i], i);
+				if (i % 10 == 0)
+				{
+					commands.destroyEntity(ids[i]);
+				}
+			}
+		});
+	}
+	for (auto& t : threads)
+	{
+		t.join();
+	}
+	CHECK(commands.size() == 110u);
+	manager.refresh();
+	for (int i = 0; i < 100; ++i)
+	{
+		if (i % 10 == 0)
+		{
+			CHECK(!manager.isValid(ids[i]));
+			continue;
+		}
+		const Entity* e = manager.getEntity(ids[i]);
+		CHECK(e != nullptr && e->getComponent<Value>().value == i);
+	}
+}
+
+int main()
+{
+	return Test::RunAll();
+}
@@ -0,0 +1,99 @@
+﻿#include "Test.hpp"
+#include "ECS/ECS.hpp"
+
+using namespace ECS;
+
+struct Counter final : ComponentData
+{
+	int value;
+	explicit Counter(const int v) : value(v) {}
+};
+
+TEST_CASE(DestroyedIdBecomesInvalid)
+{
+	EntityManager manager;
+	auto& e = manager.addEntity();
+	const EntityId id = e.getId();
+	CHECK(!id.isNull());
+	CHECK(manager.isValid(id));
+	CHECK(manager.getEntity(id) == &e);
+
+	e.destroy();
+	//refresh()までは生きている
+	CHECK(manager.isValid(id));
+	manager.refresh();
+	CHECK(!manager.isValid(id));
+	CHECK(manager.getEntity(id) == nullptr);
+}
+
+TEST_CASE(ReusedSlotGetsNewGeneration)
+{
+	EntityManager manager;
+	auto& e = manager.addEntity();
+	const EntityId oldId = e.getId();
+	e.destroy();
+	manager.refresh();
+
+	auto& reused = manager.addEntity();
+	const EntityId newId = reused.getId();
+	CHECK(newId.index == oldId.index);
+	CHECK(newId.generation != oldId.generation);
+	CHECK(newId != oldId);
+	//古いハンドルで新しいEntityに触れない
+	CHECK(!manager.isValid(oldId));
+	CHECK(manager.getEntity(oldId) == nullptr);
+	CHECK(manager.getEntity(newId) == &reused);
+}
+
+TEST_CASE(StaleIdDoesNotSeeNewComponents)
+{
+	EntityManager manager;
+	auto& e = manager.addEntity();
+	e.addComponent<Counter>(1);
+	const EntityId oldId = e.getId();
+	e.destroy();
+	manager.refresh();
+
+	auto& reused = manager.addEntity();
+	reused.addComponent<Counter>(2);
+	CHECK(reused.getId().index == oldId.index);
+	CHECK(manager.getEntity(oldId) == nullptr);
+	CHECK(reused.getComponent<Counter>().value == 2);
+}
+
+TEST_CASE(ManySlotsReuseWithoutCollision)
+{
+	EntityManager manager;
+	std::vector<EntityId> ids;
+	for (int i = 0; i < 64; ++i)
+	{
+		ids.emplace_back(manager.addEntity().getId());
+	}
+	for (int i = 0; i < 64; i += 2)
+	{
+		manager.getEntity(ids[i])->destroy();
+	}
+	manager.refresh();
+
+	std::vector<EntityId> newIds;
+	for (int i = 0; i < 32; ++i)
+	{
+		newIds.emplace_back(manager.addEntity().getId());
+	}
+	//空いたスロットだけが使われ、slotは増えない
+	for (const auto& id : newIds)
+	{
+		CHECK(id.index < 64u);
+		CHECK(id.index % 2u == 0u);
+		CHECK(manager.isValid(id));
+	}
+	for (int i = 0; i < 64; ++i)
+	{
+		CHECK(manager.isValid(ids[i]) == (i % 2 == 1));
+	}
+}
+
+int main()
+{
+	return Test::RunAll();
+}
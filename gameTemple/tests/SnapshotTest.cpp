@@ -0,0 +1,304 @@
+﻿#include "Test.hpp"
+#include "ECS/ECS.hpp"
+#include "ECS/Snapshot.hpp"
+#include <cstdio>
+#include <cstring>
+
+using namespace ECS;
+
+struct Position final : ComponentData
+{
+	float x = 0.f;
+	float y = 0.f;
+};
+
+struct Health final : ComponentData
+{
+	int hp = 0;
+	float regen = 0.f;
+};
+
+struct Name final : ComponentData
+{
+	std::string name;
+	EntityId target;
+};
+
+struct Enemy {};
+
+//!Positionを持つEntityの数を返します
+std::size_t CountPositions(const EntityManager& manager)
+{
+	std::size_t count = 0;
+	manager.view<Position>().each([&](Entity&, Position&) { ++count; });
+	return count;
+}
+
+Snapshot MakeSnapshot()
+{
+	Snapshot snapshot;
+	snapshot.addComponent<Position>(&Position::x, &Position::y)
+		.addComponent<Health>(&Health::hp, &Health::regen)
+		.addTag<Enemy>()
+		.addComponent<Name>(
+			[](SnapshotWriter& w, const Name& n) { w.writeString(n.name); w.writeEntity(n.target); },
+			[](SnapshotReader& r, Entity& e)
+	{
+		auto& n = e.addComponent<Name>();
+		n.name = r.readString();
+		n.target = r.readEntity();
+	});
+	return snapshot;
+}
+
+//!i番目のEntityはxがiになるので、xで元のEntityを見分けます
+void Populate(EntityManager& manager, const int count)
+{
+	std::vector<Entity*> named;
+	for (int i = 0; i < count; ++i)
+	{
+		auto& e = manager.addEntity(static_cast<Group>(i % 3));
+		auto& pos = e.addComponent<Position>();
+		pos.x = static_cast<float>(i);
+		pos.y = static_cast<float>(-i);
+		if (i % 2 == 1)
+		{
+			auto& health = e.addComponent<Health>();
+			health.hp = i;
+			health.regen = i * 0.5f;
+		}
+		if (i % 5 == 0)
+		{
+			e.addTag<Enemy>();
+		}
+		if (i % 10 == 0)
+		{
+			e.addComponent<Name>().name = "e" + std::to_string(i);
+			named.emplace_back(&e);
+		}
+	}
+	//名前を持つEntityは次の名前を持つEntityを指す
+	for (std::size_t i = 0; i < named.size(); ++i)
+	{
+		named[i]->getComponent<Name>().target = named[(i + 1) % named.size()]->getId();
+	}
+	manager.refresh();
+}
+
+//!元のマネージャーと読み込んだマネージャーの内容が一致するか調べます
+void CheckSameWorld(const EntityManager& loaded, const int count)
+{
+	CHECK(CountPositions(loaded) == static_cast<std::size_t>(count));
+	std::vector<int> seen(count, 0);
+	loaded.view<Position>().each([&](Entity& e, Position& pos)
+	{
+		const int i = static_cast<int>(pos.x);
+		CHECK(i >= 0 && i < count);
+		if (i < 0 || i >= count)
+		{
+			return;
+		}
+		++seen[i];
+		CHECK(pos.y == static_cast<float>(-i));
+		CHECK(e.hasGroup(static_cast<Group>(i % 3)));
+		CHECK(e.hasComponent<Health>() == (i % 2 == 1));
+		if (e.hasComponent<Health>())
+		{
+			CHECK(e.getComponent<Health>().hp == i);
+			CHECK(e.getComponent<Health>().regen == i * 0.5f);
+		}
+		CHECK(e.hasComponent<Enemy>() == (i % 5 == 0));
+		CHECK(e.hasComponent<Name>() == (i % 10 == 0));
+		if (e.hasComponent<Name>())
+		{
+			const auto& name = e.getComponent<Name>();
+			CHECK(name.name == "e" + std::to_string(i));
+			//ハンドルは読み込み先のEntityに置き換わっている
+			const Entity* target = loaded.getEntity(name.target);
+			CHECK(target != nullptr);
+			if (target != nullptr)
+			{
+				const int next = (i + 10) % ((count + 9) / 10 * 10);
+				CHECK(static_cast<int>(target->getComponent<Position>().x) == next);
+			}
+		}
+	});
+	for (int i = 0; i < count; ++i)
+	{
+		CHECK(seen[i] == 1);
+	}
+}
+
+TEST_CASE(RoundTripInMemory)
+{
+	EntityManager manager;
+	Populate(manager, 100);
+	const Snapshot snapshot = MakeSnapshot();
+	const auto data = snapshot.save(manager);
+
+	EntityManager loaded;
+	const auto result = snapshot.load(loaded, data);
+	CHECK(result.isSucceeded);
+	CHECK(result.isComplete());
+	CheckSameWorld(loaded, 100);
+	//読み込んだ状態をもう一度保存すると同じバイト列になる
+	loaded.refresh();
+	CHECK(snapshot.save(loaded) == data);
+}
+
+TEST_CASE(RoundTripThroughFile)
+{
+	EntityManager manager;
+	Populate(manager, 50);
+	const Snapshot snapshot = MakeSnapshot();
+	const std::string path = "SnapshotTest.bin";
+	CHECK(snapshot.save(manager, path));
+
+	EntityManager loaded;
+	const auto result = snapshot.load(loaded, path);
+	std::remove(path.c_str());
+	CHECK(result.isComplete());
+	CheckSameWorld(loaded, 50);
+}
+
+TEST_CASE(DestroyedEntitiesAreNotSaved)
+{
+	EntityManager manager;
+	Populate(manager, 20);
+	manager.view<Position>().each([](Entity& e, Position& pos)
+	{
+		if (pos.x >= 10.f)
+		{
+			e.destroy();
+		}
+	});
+	//refresh()前でも死んだEntityは保存しない
+	const Snapshot snapshot = MakeSnapshot();
+	EntityManager loaded;
+	CHECK(snapshot.load(loaded, snapshot.save(manager)).isSucceeded);
+	CHECK(CountPositions(loaded) == 10u);
+}
+
+TEST_CASE(MissingFileFails)
+{
+	EntityManager manager;
+	const auto result = MakeSnapshot().load(manager, std::string("SnapshotTestMissing.bin"));
+	CHECK(!result);
+	CHECK(!result.isComplete());
+}
+
+TEST_CASE(BrokenHeaderFails)
+{
+	EntityManager manager;
+	Populate(manager, 10);
+	const Snapshot snapshot = MakeSnapshot();
+	auto data = snapshot.save(manager);
+	data[0] ^= 0xFFu;
+	EntityManager loaded;
+	CHECK(!snapshot.load(loaded, data));
+	CHECK(CountPositions(loaded) == 0u);
+	CHECK(!snapshot.load(loaded, nullptr, 0u));
+}
+
+TEST_CASE(TruncatedDataCreatesNothing)
+{
+	EntityManager manager;
+	Populate(manager, 30);
+	const Snapshot snapshot = MakeSnapshot();
+	const auto data = snapshot.save(manager);
+	//どこで切れても検証で失敗し、Entityを1つも作らない
+	for (std::size_t size = 0; size < data.size(); size += 7)
+	{
+		EntityManager loaded;
+		CHECK(!snapshot.load(loaded, data.data(), size));
+		loaded.refresh();
+		CHECK(CountPositions(loaded) == 0u);
+		CHECK(loaded.getEntitiesByGroup(0).empty());
+	}
+}
+
+TEST_CASE(BadOrdinalCreatesNothing)
+{
+	EntityManager manager;
+	Populate(manager, 10);
+	const Snapshot snapshot = MakeSnapshot();
+	auto data = snapshot.save(manager);
+	//ヘッダー(20バイト)、グループ、最初のセクションのヘッダー(24バイト)の後が最初の通し番号
+	const std::size_t offset = 20u + sizeof(GroupBitSet) * 10u + 24u;
+	const std::uint32_t bad = 10u;
+	std::memcpy(&data[offset], &bad, sizeof(bad));
+	EntityManager loaded;
+	CHECK(!snapshot.load(loaded, data));
+	CHECK(loaded.getEntitiesByGroup(0).empty());
+}
+
+TEST_CASE(CustomLoaderOverReadRollsBack)
+{
+	EntityManager manager;
+	Populate(manager, 30);
+	const auto data = MakeSnapshot().save(manager);
+
+	Snapshot greedy;
+	greedy.addComponent<Position>(&Position::x, &Position::y)
+		.addComponent<Name>(
+			[](SnapshotWriter& w, const Name& n) { w.writeString(n.name); },
+			[](SnapshotReader& r, Entity& e)
+	{
+		e.addComponent<Name>();
+		(void)r.readString();
+		(void)r.readString();
+		(void)r.readString();
+	});
+	EntityManager loaded;
+	const auto result = greedy.load(loaded, data);
+	CHECK(!result);
+	CHECK(result.skippedTypes.empty());
+	//作ったEntityは削除済みで、refresh()で取り除かれる
+	loaded.view<Position>().each([](Entity& e, Position&) { CHECK(!e.isActive()); });
+	loaded.refresh();
+	CHECK(CountPositions(loaded) == 0u);
+}
+
+TEST_CASE(UnknownTypesAreSkipped)
+{
+	EntityManager manager;
+	Populate(manager, 20);
+	const auto data = MakeSnapshot().save(manager);
+
+	Snapshot partial;
+	partial.addComponent<Position>(&Position::x, &Position::y);
+	EntityManager loaded;
+	const auto result = partial.load(loaded, data);
+	CHECK(result.isSucceeded);
+	CHECK(!result.isComplete());
+	CHECK(result.skippedTypes.size() == 3u);
+	CHECK(CountPositions(loaded) == 20u);
+	std::size_t health = 0;
+	loaded.view<Health>().each([&](Entity&, Health&) { ++health; });
+	CHECK(health == 0u);
+}
+
+TEST_CASE(ChangedLayoutIsSkipped)
+{
+	EntityManager manager;
+	Populate(manager, 20);
+	const auto data = MakeSnapshot().save(manager);
+
+	//Healthのメンバの構成が保存時と違う
+	Snapshot changed;
+	changed.addComponent<Position>(&Position::x, &Position::y)
+		.addComponent<Health>(&Health::hp);
+	EntityManager loaded;
+	const auto result = changed.load(loaded, data);
+	CHECK(result.isSucceeded);
+	CHECK(std::find(result.skippedTypes.begin(), result.skippedTypes.end(), GetComponentTypeHash<Health>()) != result.skippedTypes.end());
+	std::size_t health = 0;
+	loaded.view<Health>().each([&](Entity&, Health&) { ++health; });
+	CHECK(health == 0u);
+	CHECK(CountPositions(loaded) == 20u);
+}
+
+int main()
+{
+	return Test::RunAll();
+}
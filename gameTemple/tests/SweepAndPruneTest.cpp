@@ -0,0 +1,252 @@
+﻿#include "Test.hpp"
+#include "ECS/ECS.hpp"
+#include "Components/BasicComponents.hpp"
+#include "Components/Collider.hpp"
+#include "Collision/SweepAndPrune.hpp"
+#include <set>
+
+using namespace ECS;
+
+using PairSet = std::set<std::pair<std::uint64_t, std::uint64_t>>;
+
+//!順番によらない比較のためのキーです
+std::pair<std::uint64_t, std::uint64_t> Key(const EntityId& a, const EntityId& b)
+{
+	return a.value() < b.value() ? std::make_pair(a.value(), b.value()) : std::make_pair(b.value(), a.value());
+}
+
+Entity& AddBox(EntityManager& manager, const float x, const float y, const float w, const float h)
+{
+	auto& e = manager.addEntity();
+	e.addComponent<Position2D>(x, y);
+	e.addComponent<BoxCollider>(w, h);
+	return e;
+}
+
+//!すべての組み合わせを調べて重なっているペアを求めます
+PairSet BruteForce(EntityManager& manager)
+{
+	std::vector<std::pair<EntityId, AABB>> bounds;
+	EachColliderBounds(manager, [&](Entity& e, const AABB& b) { bounds.emplace_back(e.getId(), b); });
+	PairSet pairs;
+	for (std::size_t i = 0; i < bounds.size(); ++i)
+	{
+		for (std::size_t j = i + 1; j < bounds.size(); ++j)
+		{
+			if (bounds[i].second.overlaps(bounds[j].second))
+			{
+				pairs.insert(Key(bounds[i].first, bounds[j].first));
+			}
+		}
+	}
+	return pairs;
+}
+
+//!報告された差分を適用し、重なっているペアの集合を保ちます
+void Apply(const SweepAndPrune& sap, PairSet& live)
+{
+	for (const auto& p : sap.getEndedPairs())
+	{
+		CHECK(live.erase(Key(p.a, p.b)) == 1u);
+	}
+	for (const auto& p : sap.getBeganPairs())
+	{
+		CHECK(live.insert(Key(p.a, p.b)).second);
+	}
+}
+
+TEST_CASE(FirstUpdateReportsAllOverlaps)
+{
+	EntityManager manager;
+	auto& a = AddBox(manager, 0.f, 0.f, 10.f, 10.f);
+	auto& b = AddBox(manager, 5.f, 5.f, 10.f, 10.f);
+	AddBox(manager, 100.f, 100.f, 10.f, 10.f);
+	SweepAndPrune sap;
+	sap.update(manager);
+	CHECK(sap.size() == 3u);
+	CHECK(sap.getEndedPairs().empty());
+	CHECK(sap.getBeganPairs().size() == 1u);
+	if (sap.getBeganPairs().size() == 1u)
+	{
+		const auto& p = sap.getBeganPairs()[0];
+		CHECK(Key(p.a, p.b) == Key(a.getId(), b.getId()));
+	}
+}
+
+TEST_CASE(StillSceneReportsNothing)
+{
+	EntityManager manager;
+	AddBox(manager, 0.f, 0.f, 10.f, 10.f);
+	AddBox(manager, 5.f, 5.f, 10.f, 10.f);
+	SweepAndPrune sap;
+	sap.update(manager);
+	sap.update(manager);
+	CHECK(sap.getBeganPairs().empty());
+	CHECK(sap.getEndedPairs().empty());
+	std::size_t pairs = 0;
+	sap.findPairs([&](Entity&, Entity&) { ++pairs; });
+	CHECK(pairs == 1u);
+}
+
+TEST_CASE(MovingApartEndsAndMovingBackBegins)
+{
+	EntityManager manager;
+	auto& a = AddBox(manager, 0.f, 0.f, 10.f, 10.f);
+	auto& b = AddBox(manager, 5.f, 0.f, 10.f, 10.f);
+	SweepAndPrune sap;
+	sap.update(manager);
+	CHECK(sap.getBeganPairs().size() == 1u);
+
+	//x軸だけで離れる
+	b.getComponent<Position2D>().val.x = 50.f;
+	sap.update(manager);
+	CHECK(sap.getBeganPairs().empty());
+	CHECK(sap.getEndedPairs().size() == 1u);
+	if (sap.getEndedPairs().size() == 1u)
+	{
+		const auto& p = sap.getEndedPairs()[0];
+		CHECK(Key(p.a, p.b) == Key(a.getId(), b.getId()));
+	}
+
+	//y軸だけで離れている間は重ならない
+	b.getComponent<Position2D>().val = Vec2(0.f, 50.f);
+	sap.update(manager);
+	CHECK(sap.getBeganPairs().empty());
+	CHECK(sap.getEndedPairs().empty());
+
+	b.getComponent<Position2D>().val = Vec2(0.f, 5.f);
+	sap.update(manager);
+	CHECK(sap.getBeganPairs().size() == 1u);
+	CHECK(sap.getEndedPairs().empty());
+}
+
+TEST_CASE(TouchingEdgesOverlap)
+{
+	EntityManager manager;
+	AddBox(manager, 0.f, 0.f, 10.f, 10.f);
+	auto& b = AddBox(manager, 10.f, 0.f, 10.f, 10.f);
+	SweepAndPrune sap;
+	sap.update(manager);
+	//境界を含むので接しているだけでも重なる
+	CHECK(sap.getBeganPairs().size() == 1u);
+	b.getComponent<Position2D>().val.x = 10.5f;
+	sap.update(manager);
+	CHECK(sap.getEndedPairs().size() == 1u);
+}
+
+TEST_CASE(DestroyedEntityEndsItsPairs)
+{
+	EntityManager manager;
+	auto& a = AddBox(manager, 0.f, 0.f, 10.f, 10.f);
+	auto& b = AddBox(manager, 5.f, 0.f, 10.f, 10.f);
+	auto& c = AddBox(manager, 0.f, 5.f, 10.f, 10.f);
+	SweepAndPrune sap;
+	sap.update(manager);
+	CHECK(sap.getBeganPairs().size() == 3u);
+
+	const EntityId id = a.getId();
+	a.destroy();
+	manager.refresh();
+	sap.update(manager);
+	CHECK(sap.size() == 2u);
+	CHECK(sap.getBeganPairs().empty());
+	CHECK(sap.getEndedPairs().size() == 2u);
+	for (const auto& p : sap.getEndedPairs())
+	{
+		CHECK(p.a == id || p.b == id);
+		//破棄されたEntityはハンドルで引けない
+		CHECK(manager.getEntity(id) == nullptr);
+	}
+
+	//同じ番号を再利用したEntityは別のEntityとして新しいペアになる
+	auto& reused = AddBox(manager, 0.f, 0.f, 10.f, 10.f);
+	CHECK(reused.getId().index == id.index);
+	sap.update(manager);
+	CHECK(sap.getEndedPairs().empty());
+	CHECK(sap.getBeganPairs().size() == 2u);
+	PairSet began;
+	for (const auto& p : sap.getBeganPairs())
+	{
+		began.insert(Key(p.a, p.b));
+	}
+	CHECK(began == (PairSet{ Key(reused.getId(), b.getId()), Key(reused.getId(), c.getId()) }));
+}
+
+TEST_CASE(RemovedColliderEndsItsPairs)
+{
+	EntityManager manager;
+	AddBox(manager, 0.f, 0.f, 10.f, 10.f);
+	auto& b = AddBox(manager, 5.f, 0.f, 10.f, 10.f);
+	SweepAndPrune sap;
+	sap.update(manager);
+	b.removeComponent<BoxCollider>();
+	manager.refresh();
+	sap.update(manager);
+	CHECK(sap.size() == 1u);
+	CHECK(sap.getEndedPairs().size() == 1u);
+}
+
+TEST_CASE(DeltasMatchBruteForce)
+{
+	EntityManager manager;
+	std::uint32_t seed = 7u;
+	const auto random = [&seed]()
+	{
+		seed = seed * 1103515245u + 12345u;
+		return static_cast<float>((seed >> 8) % 10000u) / 10000.f;
+	};
+	std::vector<EntityId> ids;
+	const auto spawn = [&]()
+	{
+		auto& e = manager.addEntity();
+		e.addComponent<Position2D>(random() * 400.f, random() * 400.f);
+		if (ids.size() % 2 == 0)
+		{
+			e.addComponent<BoxCollider>(4.f + random() * 20.f, 4.f + random() * 20.f);
+		}
+		else
+		{
+			e.addComponent<CircleCollider>(2.f + random() * 10.f);
+		}
+		ids.emplace_back(e.getId());
+	};
+	for (int i = 0; i < 500; ++i)
+	{
+		spawn();
+	}
+	SweepAndPrune sap;
+	PairSet live;
+	for (int frame = 0; frame < 30; ++frame)
+	{
+		sap.update(manager);
+		Apply(sap, live);
+		const PairSet expected = BruteForce(manager);
+		CHECK(live == expected);
+		PairSet found;
+		sap.findPairs([&](Entity& a, Entity& b) { found.insert(Key(a.getId(), b.getId())); });
+		CHECK(found == expected);
+
+		//少しずつ動かし、一部を破棄して新しく生成する
+		for (const auto& id : ids)
+		{
+			if (Entity* e = manager.getEntity(id))
+			{
+				e->getComponent<Position2D>().val += Vec2(random() * 6.f - 3.f, random() * 6.f - 3.f);
+			}
+		}
+		for (int i = 0; i < 10; ++i)
+		{
+			if (Entity* e = manager.getEntity(ids[static_cast<std::size_t>(random() * ids.size())]))
+			{
+				e->destroy();
+			}
+			spawn();
+		}
+		manager.refresh();
+	}
+}
+
+int main()
+{
+	return Test::RunAll();
+}
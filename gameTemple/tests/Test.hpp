@@ -0,0 +1,69 @@
+﻿/**
+* @file Test.hpp
+* @brief DXライブラリなしで動かすテストの小さな仕組みです
+* @details TEST_CASEで関数を登録し、main()でTest::RunAll()を呼びます
+* @author agent
+* @date 2026/10/17
+*/
+#pragma once
+#include <iostream>
+#include <vector>
+
+namespace Test
+{
+	struct Case final
+	{
+		const char* name;
+		void(*func)();
+	};
+	inline std::vector<Case>& GetCases()
+	{
+		static std::vector<Case> cases;
+		return cases;
+	}
+	inline int& GetFailures()
+	{
+		static int failures = 0;
+		return failures;
+	}
+	//!静的変数の初期化でテストを登録します
+	struct Register final
+	{
+		Register(const char* name, void(*func)())
+		{
+			GetCases().push_back({ name, func });
+		}
+	};
+	//!登録したテストをすべて実行し、失敗があれば1を返します
+	inline int RunAll()
+	{
+		int failedCases = 0;
+		for (const auto& c : GetCases())
+		{
+			const int before = GetFailures();
+			c.func();
+			const bool ok = GetFailures() == before;
+			std::cout << (ok ? "[  OK  ] " : "[ FAIL ] ") << c.name << std::endl;
+			failedCases += ok ? 0 : 1;
+		}
+		std::cout << GetCases().size() - failedCases << "/" << GetCases().size() << " passed" << std::endl;
+		return failedCases == 0 ? 0 : 1;
+	}
+}
+
+//!テストを定義して登録します
+#define TEST_CASE(name) \
+	static void name(); \
+	static const Test::Register name##Register(#name, name); \
+	static void name()
+
+//!条件が偽ならファイル名と行数を出力して失敗を記録します
+#define CHECK(expr) \
+	do \
+	{ \
+		if (!(expr)) \
+		{ \
+			std::cout << __FILE__ << ":" << __LINE__ << ": CHECK(" #expr ") failed" << std::endl; \
+			++Test::GetFailures(); \
+		} \
+	} while (false)
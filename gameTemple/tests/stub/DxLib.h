@@ -0,0 +1,23 @@
+﻿/**
+* @file DxLib.h
+* @brief テストでコンポーネントを読み込むためのDXライブラリの代わりです
+* @details 描画は何もしません。テストで使う宣言だけを用意しています
+* @author agent
+* @date 2026/10/17
+*/
+#pragma once
+#include "windows.h"
+
+struct VECTOR { float x, y, z; };
+struct COLOR_F { float r, g, b, a; };
+struct MATERIALPARAM { COLOR_F Diffuse, Ambient, Specular, Emissive; float Power; };
+
+inline VECTOR VGet(float x, float y, float z) { return { x, y, z }; }
+inline COLOR_F GetColorF(float r, float g, float b, float a) { return { r, g, b, a }; }
+inline unsigned int GetColor(int, int, int) { return 0u; }
+inline int SetMaterialParam(MATERIALPARAM) { return 0; }
+inline int DrawBoxAA(float, float, float, float, unsigned int, int, float = 1.f) { return 0; }
+inline int DrawCircleAA(float, float, float, int, unsigned int, int, float = 1.f) { return 0; }
+inline int DrawLineAA(float, float, float, float, unsigned int, float = 1.f) { return 0; }
+inline int DrawCube3D(VECTOR, VECTOR, unsigned int, unsigned int, int) { return 0; }
+inline int DrawSphere3D(VECTOR, float, int, unsigned int, unsigned int, int) { return 0; }
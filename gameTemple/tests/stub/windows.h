@@ -0,0 +1,14 @@
+﻿/**
+* @file windows.h
+* @brief テストでUtility.hppを読み込むためのWin32 APIの代わりです
+* @author agent
+* @date 2026/10/17
+*/
+#pragma once
+#include <cstdio>
+
+inline void AllocConsole() {}
+inline void FreeConsole() {}
+inline int freopen_s(std::FILE**, const char*, const char*, std::FILE*) { return 0; }
+inline void OutputDebugString(const char*) {}
+#define __noop ((void)0)